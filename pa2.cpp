@@ -1,447 +1,3984 @@
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <algorithm>
-#include <string>
-#include <cmath>
-#include <random>
-#include <chrono>
-#include <utility>
-#include <unordered_set>
-#include <climits>
-#include "MurmurHash3.h"
-
-using namespace std;
-
-
-/**************************************
- * Board State class
- *
- * Be wary, action functions do not check
- * whether the action is applicable
- * to the board state.
- **************************************/
-class Board {
-public:
-    static const uint32_t HASHSEED = 0x9747b28c;
-    static const int ROWS = 4;
-    static const int COLS = 4;
-    int board[ROWS][COLS];
-    int i_cord;
-    int j_cord;
-    int F;
-
-    enum Action { UP, DOWN, LEFT, RIGHT };
-
-    Board() : i_cord(3), j_cord(3) {
-        for (int i = 0; i < 15; ++i)
-            board[i / 4][i % 4] = i + 1;
-        board[3][3] = 0;
-    }
-
-    Board(const Board &obj)
-    {
-        for (int i = 0; i < 4; ++i)
-            for (int j = 0; j < 4; ++j)
-                board[i][j] = obj.board[i][j];
-        i_cord = obj.i_cord;
-        j_cord = obj.j_cord;
-        F = obj.F;
-    }
-
-
-    Board(Board &b, Action a) : i_cord(b.i_cord), j_cord(b.j_cord) {
-        for (int i = 0; i < 4; ++i)
-            for (int j = 0; j < 4; ++j)
-                board[i][j] = b.board[i][j];
-
-        switch (a) {
-        case UP:    up();    break;
-        case DOWN:  down();  break;
-        case LEFT:  left();  break;
-        case RIGHT: right(); break;
-        }
-    }
-
-    bool operator==(const Board &b) const {
-        for (int i = 0; i < 4; ++i)
-            for (int j = 0; j < 4; ++j)
-                if (board[i][j] != b.board[i][j])
-                    return false;
-        return true;
-    }
-
-    Board& up() {
-        swap(board[i_cord][j_cord], board[i_cord - 1][j_cord]);
-        --i_cord;
-        return *this;
-    }
-
-    Board& down() {
-        swap(board[i_cord][j_cord], board[i_cord + 1][j_cord]);
-        ++i_cord;
-        return *this;
-    }
-
-    Board& left() {
-        swap(board[i_cord][j_cord], board[i_cord][j_cord - 1]);
-        --j_cord;
-        return *this;
-    }
-
-    Board& right() {
-        swap(board[i_cord][j_cord], board[i_cord][j_cord + 1]);
-        ++j_cord;
-        return *this;
-    }
-
-    void print() {
-        for (int i = 0; i < 4; ++i) {
-            for (int j = 0; j < 4; ++j) {
-                int v = board[i][j];
-                if (v < 10) cout << ' ';
-                cout << ' ' << v;
-            }
-            cout << endl;
-        }
-    }
-};
-
-// Implement std::hash<Board> so we can use std::unordered_set<Board>
-namespace std
-{
-    template<>
-    struct hash<Board> {
-        size_t operator()(const Board &b) const {
-            uint32_t hash;
-            MurmurHash3_x86_32(&b.board, sizeof(b.board), Board::HASHSEED, &hash);
-            return hash;
-        }
-    };
-}
-
-
-/****************************
- * Abstract Heuristic class
- ****************************/
-class Heuristic {
-public:
-    virtual int operator()(Board &b) = 0;
-    virtual string get_name() = 0;
-};
-
-
-/*******************************
- * Heuristic Implementations
- *******************************/
-class ManhattanDistance : public Heuristic {
-public:
-    virtual int operator()(Board &b) {
-        int MD = 0;
-        for (int i = 0; i < 16; ++i) {
-            int x = i / 4;
-            int y = i % 4;
-            int v = b.board[x][y];
-            if (v > 0) {
-                int x_dest = (v - 1) / 4;
-                int y_dest = (v - 1) % 4;
-                MD += abs(x - x_dest) + abs(y - y_dest);
-            }
-        }
-        return MD;
-    }
-
-    virtual string get_name() {
-        return "Manhattan Distance";
-    }
-};
-
-//
-// Linear conflict correction:
-// Look at every line of the puzzle. If you find two tiles there which are supposed to end up in this line,
-// but which are currently in the wrong order, then you know that the Manhattan distance is too optimistic
-// and you actually need at least 2 more moves to get the two tiles past each other.  One can prove that the
-// heuristic function remains admissible (in fact monotone) even if you add 2 for every pair with this problem
-// in any row. The same applies to every pair with the analogous problem in any column.
-//
-class LinearConflictMD : public ManhattanDistance {
-    Board solved = Board();
-
-    inline bool isValidForRow(int row, int x)
-    {
-        return (x >= solved.board[row][0] && x <= solved.board[row][Board::COLS - 1]);
-    }
-
-    int getRowCount(Board &b)
-    {
-        int count = 0;
-        for (int row = 0; row < Board::ROWS; row++)
-        {
-            for (int column = 0; column < Board::COLS - 2; column++)
-            {
-                int left = b.board[row][column];
-                int right = b.board[row][column + 1];
-                int correct_right = solved.board[row][column + 1];
-                if (left == solved.board[row][column] && isValidForRow(row, right))
-                {
-                    if (right != correct_right)
-                        count++;
-                }
-            }
-        }
-        return count;
-    }
-
-public:
-    virtual int operator()(Board &b) {
-        return ManhattanDistance::operator()(b) + getRowCount(b) * 2;
-    }
-
-    virtual string get_name() {
-        return "MD + Linear Conflict Correction";
-    }
-};
-
-
-class InversionDistance : public Heuristic {
-public:
-    virtual int operator()(Board &b) {
-        int h_inv = 0;
-        int v_inv = 0;
-        for (int i = 0; i < 16; ++i) {
-            for (int j = i + 1; j < 16; ++j) {
-                int x = b.board[i / 4][i % 4];
-                int y = b.board[j / 4][j % 4];
-                if (x * y > 0) {    // ignore inversions with empty square
-                    if (x > y) ++h_inv;
-
-                    // map to column major ordering
-                    int vi = 4 * (i % 4) + i / 4;
-                    int vj = 4 * (j % 4) + j / 4;
-                    int vx = 4 * ((x - 1) % 4) + (x - 1) / 4;
-                    int vy = 4 * ((y - 1) % 4) + (y - 1) / 4;
-                    if ((vx > vy) != (vi > vj)) ++v_inv;
-                }
-            }
-        }
-        return ceil(h_inv / 3.0) + ceil(v_inv / 3.0);
-    }
-
-    virtual string get_name() {
-        return "Inversion Distance";
-    }
-};
-
-
-/*****************************************
- * Problem class
- *
- * Contains the heuristic, successor, and
- * goal_test functions. Also contains a
- * scramble function, that generates
- * solvable starting states, and print
- * function that prints a sequence of board
- * states.
- *****************************************/
-class Problem {
-    mt19937 randgen;
-public:
-    Heuristic &h;
-
-    Problem(Heuristic &h) : h(h), randgen(mt19937(chrono::system_clock::now().time_since_epoch().count())) {}
-
-    vector<Board> successors(Board &b) {
-        vector<Board> succ;
-        if (b.i_cord > 0) succ.emplace_back(b, Board::UP);
-        if (b.i_cord < 3) succ.emplace_back(b, Board::DOWN);
-        if (b.j_cord > 0) succ.emplace_back(b, Board::LEFT);
-        if (b.j_cord < 3) succ.emplace_back(b, Board::RIGHT);
-        return succ;
-    }
-
-    bool goal_test(Board &b) {
-        return h(b) == 0;
-    }
-
-    Board scramble(int m) {
-        Board b;
-        for (int i = 0; i < m; ++i) {
-            vector<Board> succ = successors(b);
-            int r = randgen() % succ.size();
-            b = succ[r];
-        }
-        return b;
-    }
-
-    void print(vector<Board> &path) {
-        for (Board &b : path) {
-            b.print();
-            cout << endl;
-        }
-    }
-};
-
-// Debugging helper function
-void pause(Board &b, Problem &p, int f) {
-    b.print();
-    cout << "h: " << p.h(b) << ", f: " << f << endl << "paused..." << endl << endl;
-    string s;
-    getline(cin, s);
-}
-
-/*************************
- * IDA* Search Algorithm *
- *************************/
-int DL_A_star(vector<Board> &path, unordered_set<Board> &pathSet, Problem &p, int g, int f_limit, int &nodes_expanded) {
-    Board &b = path.back();
-    int f = g + p.h(b);
-    ++nodes_expanded;
-    //pause(b, p, f);
-    if (f > f_limit) return f;
-    if (p.goal_test(b)) return f;
-    int f_min = INT_MAX;
-    for (Board &s : p.successors(b)) {
-        if (pathSet.find(s) == pathSet.end()) {
-            path.push_back(s);
-            pathSet.insert(s);
-            f = DL_A_star(path, pathSet, p, g + 1, f_limit, nodes_expanded);
-            if (f <= f_limit) return f; // if goal is found, return length
-            if (f < f_min) f_min = f;   // if smallest over limit, update f_min
-            path.pop_back();
-            pathSet.erase(s);
-        }
-    }
-    return f_min;                       // return smallest over limit
-}
-
-vector<Board> ID_A_star(Board &start, Problem &p, int &nodes_expanded) {
-    int f_limit = p.h(start);
-    vector<Board> path{ start };
-    unordered_set<Board> pathSet{ start };
-    while (1) {
-        int f_min = DL_A_star(path, pathSet, p, 0, f_limit, nodes_expanded);
-        if (f_min <= f_limit) return path;              // if goal is found, return path
-        if (f_min == INT_MAX) return vector<Board>();   // if failure, return empty path
-        f_limit = f_min;
-    }
-}
-
-/**********************
- *   RBFS Algorithm   *     // with path checking
- **********************/
-bool ascF(Board &b1, Board &b2) { return b1.F < b2.F; }
-
-int RBFS(vector<Board> &path, unordered_set<Board> &pathSet, Problem &p, int g, int f_limit, int &nodes_expanded) {
-    Board &b = path.back();
-    ++nodes_expanded;
-    if (p.goal_test(b)) return b.F;
-    vector<Board> successors;
-    for (Board &s : p.successors(b)) {
-        if (pathSet.find(s) == pathSet.end()) { // only consider states not already visited on current path
-            s.F = max(g + p.h(s), b.F);         // (and their siblings, which are stored in memory as well)
-            successors.push_back(s);
-        }
-    }
-    if (successors.empty()) return INT_MAX;
-    if (successors.size() == 1) {   // If there is only one successor,
-        successors.emplace_back();      // add a dummy element so we can use same logic in loop,
-        successors.back().F = INT_MAX;  // but make sure it never gets expanded.
-    }
-    while (1) {
-        sort(successors.begin(), successors.end(), ascF);
-        Board &best = successors[0];
-        if (best.F > f_limit) return best.F;
-        int new_f_limit = min(f_limit, successors[1].F);
-        path.push_back(best);
-        pathSet.insert(best);
-        best.F = RBFS(path, pathSet, p, g + 1, new_f_limit, nodes_expanded);
-        if (best.F <= new_f_limit) return best.F;
-        path.pop_back();
-        pathSet.erase(best);
-    }
-}
-
-vector<Board> RecursiveBestFirst(Board &start, Problem &p, int &nodes_expanded) {
-    start.F = p.h(start);
-    vector<Board> path{ start };
-    unordered_set<Board> pathSet{ start };
-    RBFS(path, pathSet, p, 1, INT_MAX, nodes_expanded);
-    return path;
-}
-
-
-void csv_write_headers(std::ofstream& f) {
-    f << "Board_ID, Scramble_Number, Algorithm, Heuristic, Moves, Nodes_Expanded, Computation_Time(us)" << endl;
-}
-
-void csv_write_row(std::ofstream& f, int board_id, int scramble_num, string algo, string heuristic, size_t moves, int nodes_exp, long microseconds) {
-    long micros = std::max(1L, microseconds);
-    f << board_id << "," << scramble_num << "," << algo << "," << heuristic << "," << moves << "," << nodes_exp << "," << micros << endl;
-}
-
-int main()
-{
-    const int TOTAL_TRIALS = 10000;
-    LinearConflictMD  lc;
-    ManhattanDistance md;
-    InversionDistance id;
-    vector<Heuristic*> heuristics = { &md, &lc, &id };
-
-    std::ofstream csv_file;
-    string filename = "pa2-" + std::to_string(TOTAL_TRIALS) + ".csv";
-    csv_file.open(filename);
-    csv_write_headers(csv_file);
-    int b_id = 0;
-
-    for (int scramble_size = 10; scramble_size <= 50; scramble_size += 10) {
-        cout << "Scramble size: " << scramble_size << " trial: ";
-        for (int num_trials = 0; num_trials < TOTAL_TRIALS; num_trials++) {
-            if (num_trials % (TOTAL_TRIALS / 10) == 0)
-                cout << num_trials << " ";
-            for (Heuristic* heuristic : heuristics) {
-                Problem p_rbfs(*heuristic);
-                Board start_rbfs = p_rbfs.scramble(scramble_size);
-                ++b_id;
-
-                // RBFS Algorithm
-                int nodes_expanded = 0;
-                chrono::time_point<chrono::high_resolution_clock> t0, t1;
-                t0 = chrono::high_resolution_clock::now();
-                vector<Board> solution_RBFS = RecursiveBestFirst(start_rbfs, p_rbfs, nodes_expanded);
-                t1 = chrono::high_resolution_clock::now();
-                chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(t1 - t0);
-                //p.print(solution);
-                csv_write_row(csv_file, b_id, scramble_size, "RBFS", heuristic->get_name(), solution_RBFS.size() - 1, nodes_expanded, duration.count());
-            }
-        }
-        cout << endl;
-    }
-
-    for (int scramble_size = 10; scramble_size <= 50; scramble_size += 10) {
-        cout << "Scramble size: " << scramble_size << " trial: ";
-        for (int num_trials = 0; num_trials < TOTAL_TRIALS; num_trials++) {
-            if (num_trials % (TOTAL_TRIALS / 10) == 0)
-                cout << num_trials << " ";
-            for (Heuristic* heuristic : heuristics) {
-                Problem p_ida(*heuristic);
-                Board start_ida = p_ida.scramble(scramble_size);
-                ++b_id;
-
-                // IDA* Algorithm
-                int nodes_expanded = 0;
-                chrono::time_point<chrono::high_resolution_clock> t0, t1;
-                t0 = chrono::high_resolution_clock::now();
-                vector<Board> solution_A_star = ID_A_star(start_ida, p_ida, nodes_expanded);
-                t1 = chrono::high_resolution_clock::now();
-                chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(t1 - t0);
-                //p.print(solution);
-                csv_write_row(csv_file, b_id, scramble_size, "IDA*", heuristic->get_name(), solution_A_star.size() - 1, nodes_expanded, duration.count());
-            }
-        }
-        cout << endl;
-    }
-
-
-
-    csv_file.close();
-}
\ No newline at end of file
+// Build: g++ -std=c++17 -O3 -pthread pa2.cpp MurmurHash3.cpp -o pa2
+// Add -DPA2_STATS for the per-solve search statistics written by --trace.
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <cmath>
+#include <random>
+#include <chrono>
+#include <utility>
+#include <unordered_set>
+#include <climits>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <deque>
+#include <typeinfo>
+#include <array>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(PA2_STATS) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "MurmurHash3.h"
+
+using namespace std;
+
+// Puzzle size, fixed at compile time so all index math folds to constants:
+// -DPA2_ROWS=3 -DPA2_COLS=3 builds the 8-puzzle, -DPA2_ROWS=5 -DPA2_COLS=5
+// the 24-puzzle. Rows and columns are at most 5 cells long.
+#ifndef PA2_ROWS
+#define PA2_ROWS 4
+#endif
+#ifndef PA2_COLS
+#define PA2_COLS 4
+#endif
+
+// Boards pack their tiles into one word: 4 bits per cell in 64 bits up to
+// 16 cells, and 5 bits per cell in 128 bits beyond, up to 25.
+const int TILE_BITS = PA2_ROWS * PA2_COLS <= 16 ? 4 : 5;
+typedef conditional<TILE_BITS == 4, uint64_t, unsigned __int128>::type Tiles;
+const int TILE_SLOTS = 8 * sizeof(Tiles) / TILE_BITS;     // cells a word has room for
+const int TILE_MASK = (1 << TILE_BITS) - 1;
+
+// 64 bits of a tile word for hashing: the word itself, or its halves xored
+inline uint64_t fold_tiles(Tiles t) {
+    return (uint64_t)t ^ (uint64_t)(t >> 63 >> 1);
+}
+
+
+/**************************************
+ * Zobrist keys
+ *
+ * A board's key is the xor of a random
+ * number for every (cell, tile) pair, with
+ * zero for the blank, so a move changes it
+ * by two xors.
+ **************************************/
+// Vigna's splitmix64: one add and a 64-bit mix per number. Its output is
+// the same on every platform, unlike the std distributions.
+struct SplitMix64 {
+    uint64_t state;
+
+    static constexpr uint64_t mix(uint64_t r) {
+        r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        r = (r ^ (r >> 27)) * 0x94D049BB133111EBULL;
+        return r ^ (r >> 31);
+    }
+
+    constexpr uint64_t operator()() {
+        return mix(state += 0x9E3779B97F4A7C15ULL);
+    }
+
+    // Uniform in [0, n), reading `bits` as a fraction: the integer part of
+    // bits * n is the draw and the fractional part is left for the next one.
+    // Each draw uses up about log2(n) bits, so one number does for several.
+    static uint32_t take(uint64_t &bits, uint32_t n) {
+        unsigned __int128 p = (unsigned __int128)bits * n;
+        bits = (uint64_t)p;
+        return p >> 64;
+    }
+};
+
+// z[c][v] for tile v in cell c, filled in at compile time by splitmix64.
+// Cells past the board's last are always blank and add nothing.
+struct ZobristTable {
+    uint64_t z[TILE_SLOTS][TILE_SLOTS];
+    constexpr ZobristTable() : z() {
+        SplitMix64 rng{ 0x9747b28c };
+        for (int c = 0; c < TILE_SLOTS; ++c)
+            for (int v = 1; v < TILE_SLOTS; ++v)
+                z[c][v] = rng();
+    }
+};
+
+constexpr ZobristTable ZOBRIST{};
+
+constexpr uint64_t zobrist_key(Tiles tiles) {
+    uint64_t k = 0;
+    for (int c = 0; c < TILE_SLOTS; ++c)
+        k ^= ZOBRIST.z[c][(int)(tiles >> (TILE_BITS * c)) & TILE_MASK];
+    return k;
+}
+
+// Tile i + 1 in cell i, blank in the last cell
+constexpr Tiles goal_tiles(int cells) {
+    Tiles t = 0;
+    for (int c = 0; c < cells - 1; ++c)
+        t |= (Tiles)(c + 1) << (TILE_BITS * c);
+    return t;
+}
+
+
+/**************************************
+ * Board State class
+ *
+ * Be wary, action functions do not check
+ * whether the action is applicable
+ * to the board state.
+ **************************************/
+class Board {
+public:
+    static const uint32_t HASHSEED = 0x9747b28c;
+    static const int ROWS = PA2_ROWS;
+    static const int COLS = PA2_COLS;
+    static const int CELLS = ROWS * COLS;
+    static constexpr Tiles GOAL = goal_tiles(CELLS);
+    static constexpr uint64_t GOAL_KEY = zobrist_key(GOAL);
+
+    // The line tables of LC and WD are indexed by a whole row or column
+    static_assert(ROWS >= 2 && ROWS <= 5 && COLS >= 2 && COLS <= 5, "boards are 2 x 2 up to 5 x 5");
+
+    Tiles tiles;        // TILE_BITS per cell, cell 0 (top left) in the lowest bits
+    uint64_t key;       // Zobrist hash of tiles, kept up to date by every move
+    int blank;          // cell index of the empty square
+    int H;              // heuristic state (see Heuristic::update)
+
+    // Actions move the blank. Each action's inverse is the action ^ 1; NONE
+    // (no previous move) has no inverse among the real actions.
+    enum Action { UP, DOWN, LEFT, RIGHT, NONE };
+
+    Board() : tiles(GOAL), key(GOAL_KEY), blank(CELLS - 1), H(0) {}
+
+    Board(Tiles tiles, int blank) : tiles(tiles), key(zobrist_key(tiles)), blank(blank), H(0) {}
+
+    Board(const Board &b, Action a) : tiles(b.tiles), key(b.key), blank(b.blank), H(b.H) {
+        slide(target(a));
+    }
+
+    static Action inverse(Action a) { return Action(a ^ 1); }
+
+    // cell the blank moves to under action a
+    int target(Action a) const {
+        static const int offset[] = { -COLS, COLS, -1, 1 };
+        return blank + offset[a];
+    }
+
+    bool operator==(const Board &b) const {
+        return tiles == b.tiles;
+    }
+
+    int get(int cell) const {
+        return (int)(tiles >> (TILE_BITS * cell)) & TILE_MASK;
+    }
+
+    int get(int i, int j) const {
+        return get(i * COLS + j);
+    }
+
+    void set(int cell, int v) {
+        key ^= ZOBRIST.z[cell][get(cell)] ^ ZOBRIST.z[cell][v];
+        tiles = (tiles & ~((Tiles)TILE_MASK << (TILE_BITS * cell))) | ((Tiles)v << (TILE_BITS * cell));
+        if (v == 0) blank = cell;
+    }
+
+    // Contents of a row or column as a key of TILE_BITS per cell, first cell
+    // in the lowest bits
+    int row(int r) const {
+        return (int)(tiles >> (TILE_BITS * COLS * r)) & ((1 << (TILE_BITS * COLS)) - 1);
+    }
+
+    int column(int c) const {
+        if (ROWS == 4 && COLS == 4) {
+            uint64_t x = (tiles >> (4 * c)) & 0x000F000F000F000FULL;
+            x |= x >> 12;   // c + 4 next to c, c + 12 next to c + 8
+            x |= x >> 24;   // c + 8 and c + 12 next to c + 4
+            return x & 0xFFFF;
+        }
+        int key = 0;
+        for (int r = 0; r < ROWS; ++r)
+            key |= get(r, c) << (TILE_BITS * r);
+        return key;
+    }
+
+    int i_cord() const { return blank / COLS; }
+    int j_cord() const { return blank % COLS; }
+
+    // Slide the tile in cell c into the blank. The blank's bits are always
+    // zero, so a single xor clears the old cell and fills the new one.
+    Board& slide(int c) {
+        int t = get(c);
+        tiles ^= ((Tiles)t << (TILE_BITS * c)) | ((Tiles)t << (TILE_BITS * blank));
+        key ^= ZOBRIST.z[c][t] ^ ZOBRIST.z[blank][t];
+        blank = c;
+        return *this;
+    }
+
+    // Read CELLS tile numbers (0 for the blank) in row major order.
+    bool read(istream &in) {
+        Board b(0, 0);
+        uint32_t seen = 0;
+        for (int c = 0; c < CELLS; ++c) {
+            int v;
+            if (!(in >> v) || v < 0 || v >= CELLS || (seen & (1u << v))) return false;
+            seen |= 1u << v;
+            b.set(c, v);
+        }
+        *this = b;
+        return true;
+    }
+
+    // A horizontal move changes neither the order of the tiles nor the
+    // blank's row; a vertical one jumps a tile over COLS - 1 others and moves
+    // the blank one row. With an odd width the parity of the inversions is
+    // therefore invariant, and with an even width the parity of inversions
+    // plus blank row. The goal has no inversions and the blank in the last row.
+    bool solvable() const {
+        int inv = 0;
+        for (int i = 0; i < CELLS; ++i)
+            for (int j = i + 1; j < CELLS; ++j)
+                if (get(i) && get(j) && get(i) > get(j)) ++inv;
+        return solvable_parity(inv, i_cord());
+    }
+
+    // Whether a board with `inv` inversions and the blank in row `blank_row`
+    // is solvable
+    static bool solvable_parity(int inv, int blank_row) {
+        if (COLS % 2) return inv % 2 == 0;
+        return (inv + blank_row) % 2 == (ROWS - 1) % 2;
+    }
+
+    Board& up()    { return slide(blank - COLS); }
+    Board& down()  { return slide(blank + COLS); }
+    Board& left()  { return slide(blank - 1); }
+    Board& right() { return slide(blank + 1); }
+
+    void print() const {
+        for (int i = 0; i < ROWS; ++i) {
+            for (int j = 0; j < COLS; ++j) {
+                int v = get(i, j);
+                if (v < 10) cout << ' ';
+                cout << ' ' << v;
+            }
+            cout << endl;
+        }
+    }
+};
+
+// Implement std::hash<Board> so we can use std::unordered_set<Board>. Build
+// with -DPA2_CHECK_HASH to check every key against one computed from scratch.
+namespace std
+{
+    template<>
+    struct hash<Board> {
+        size_t operator()(const Board &b) const {
+#ifdef PA2_CHECK_HASH
+            if (b.key != zobrist_key(b.tiles)) {
+                cerr << "Stale Zobrist key " << hex << b.key << " for tiles " << fold_tiles(b.tiles) << dec << endl;
+                abort();
+            }
+#endif
+            return b.key;
+        }
+    };
+}
+
+// The board hash before Zobrist keys, kept for comparison in the benchmarks
+uint32_t murmur_hash(const Board &b) {
+    uint32_t hash;
+    MurmurHash3_x86_32(&b.tiles, sizeof(b.tiles), Board::HASHSEED, &hash);
+    return hash;
+}
+
+/*****************************************
+ * Permutation ranking
+ *
+ * Dense lexicographic indexes for
+ * sequences of distinct values below n:
+ * each value is replaced by its rank among
+ * the values not used so far, one popcount
+ * per digit, giving mixed radix digits
+ * n, n - 1, ... A sequence of k values has
+ * one of n!/(n-k)! ranks.
+ *
+ * Whole boards rank among the CELLS!/2
+ * solvable ones by the blank's cell and
+ * the order of the other tiles. With
+ * the blank fixed, solvability is the
+ * parity of that order's inversions, and
+ * orders of rank 2m and 2m+1 differ by one
+ * swap, so half the rank is dense. Past
+ * 20 cells that index no longer fits in 64
+ * bits, and BOARD_RANKS is false.
+ *****************************************/
+constexpr uint64_t factorial(int n) {
+    return n <= 1 ? 1 : n * factorial(n - 1);
+}
+
+const bool BOARD_RANKS = Board::CELLS <= 20;
+const uint64_t TILE_ORDERS = BOARD_RANKS ? factorial(Board::CELLS - 1) / 2 : 1;     // per blank cell
+const uint64_t SOLVABLE_BOARDS = Board::CELLS * TILE_ORDERS;
+
+// Up to 16 values, counts of used smaller values are kept in nibbles of one
+// word, so a digit costs a shift and an add. Beyond, a popcount over the
+// used values does.
+inline uint64_t perm_rank(const int *x, int k, int n = Board::CELLS) {
+    uint64_t idx = 0;
+    if (Board::CELLS > 16) {
+        uint32_t used = 0;
+        for (int i = 0; i < k; ++i) {
+            idx = idx * (n - i) + x[i] - __builtin_popcount(used & ((1u << x[i]) - 1));
+            used |= 1u << x[i];
+        }
+        return idx;
+    }
+    uint64_t smaller = 0;               // nibble v: used values below v
+    for (int i = 0; i < k; ++i) {
+        idx = idx * (n - i) + x[i] - ((smaller >> (4 * x[i])) & 0xF);
+        smaller += (0x1111111111111111ULL << (4 * x[i])) << 4;
+    }
+    return idx;
+}
+
+// Next digit of idx in the given radix. Ranks fit in 32 bits after a few
+// digits, and 32-bit division is several times faster.
+inline int take_digit(uint64_t &idx, int radix) {
+    if (idx >> 32) {
+        int d = idx % radix;
+        idx /= radix;
+        return d;
+    }
+    uint32_t i = idx;
+    idx = i / radix;
+    return i % radix;
+}
+
+// Values with the given Lehmer digits: x[i] is the digit[i]-th smallest
+// value not used before i. Up to 16 values the unused ones are kept in order
+// in the nibbles of one word, so taking one out is a few shifts.
+inline void from_lehmer(const int *digit, int *x, int k) {
+    if (Board::CELLS > 16) {
+        int unused[Board::CELLS];
+        for (int v = 0; v < Board::CELLS; ++v)
+            unused[v] = v;
+        for (int i = 0; i < k; ++i) {
+            x[i] = unused[digit[i]];
+            copy(unused + digit[i] + 1, unused + Board::CELLS - i, unused + digit[i]);
+        }
+        return;
+    }
+    uint64_t unused = 0xFEDCBA9876543210ULL;
+    for (int i = 0; i < k; ++i) {
+        int s = 4 * digit[i];
+        uint64_t low = unused & ((1ULL << s) - 1);
+        x[i] = (unused >> s) & 0xF;
+        unused = low | ((unused >> s) >> 4 << s);
+    }
+}
+
+inline void perm_unrank(uint64_t idx, int *x, int k, int n = Board::CELLS) {
+    int digit[Board::CELLS];
+    for (int i = k - 1; i >= 0; --i)
+        digit[i] = take_digit(idx, n - i);
+    from_lehmer(digit, x, k);
+}
+
+// Index of a solvable board in [0, SOLVABLE_BOARDS); only with BOARD_RANKS
+inline uint64_t rank_board(const Board &b) {
+    int order[Board::CELLS - 1];
+    int n = 0;
+    for (int c = 0; c < Board::CELLS; ++c)
+        if (c != b.blank) order[n++] = b.get(c) - 1;
+    return b.blank * TILE_ORDERS + (perm_rank(order, n, n) >> 1);
+}
+
+// The digits of the order's full rank 2r + p are r's digits, then p and 0.
+// The digits add up to the order's inversions, so p is the one bit that
+// makes the board solvable.
+inline Board unrank_board(uint64_t idx) {
+    const int n = Board::CELLS - 1;
+    int blank = idx / TILE_ORDERS;
+    uint64_t r = idx % TILE_ORDERS;
+    int digit[n];
+    int inv = 0;
+    for (int i = n - 3; i >= 0; --i) {
+        digit[i] = take_digit(r, n - i);
+        inv += digit[i];
+    }
+    digit[n - 2] = Board::solvable_parity(inv, blank / Board::COLS) ? 0 : 1;
+    digit[n - 1] = 0;
+    int order[n];
+    from_lehmer(digit, order, n);
+    Board b(0, blank);
+    for (int c = 0, i = 0; c < Board::CELLS; ++c)
+        if (c != blank) b.set(c, order[i++] + 1);
+    return b;
+}
+
+
+/****************************
+ * Abstract Heuristic class
+ ****************************/
+class Heuristic {
+public:
+    virtual int operator()(Board &b) = 0;
+    virtual string get_name() = 0;
+
+    // Incremental evaluation. init() returns the heuristic state of b, and
+    // update() returns the state of child b reached by sliding `tile` from
+    // cell `from` into the blank at cell `to`, given the parent's state s.
+    // The h value is the low byte of a state; heuristics may keep extra
+    // bookkeeping (e.g. inversion counts) in the upper bits.
+    virtual int init(Board &b) { return (*this)(b); }
+    virtual int update(Board &b, int s, int tile, int from, int to) { return (*this)(b); }
+
+    static int value(int s) { return s & 0xFF; }
+};
+
+
+/*******************************
+ * Heuristic Implementations
+ *******************************/
+class ManhattanDistance : public Heuristic {
+public:
+    virtual int operator()(Board &b) {
+        return full_kernel(b.tiles);
+    }
+
+    virtual int update(Board &b, int s, int tile, int from, int to) {
+        return s + tile_distance(tile, to) - tile_distance(tile, from);
+    }
+
+    // States of the n children of b (state s) reached by acts, in one pass
+    static void update_all(const Board &b, int s, const Board::Action *acts, int n, int *out) {
+        for (int i = 0; i < n; ++i) {
+            int from = b.target(acts[i]);
+            int tile = b.get(from);
+            out[i] = s + tile_distance(tile, b.blank) - tile_distance(tile, from);
+        }
+    }
+
+    virtual string get_name() {
+        return "Manhattan Distance";
+    }
+
+    static int tile_distance(int v, int cell) {
+        return DISTANCE.d[v][cell];
+    }
+
+private:
+    // d[v][c]: moves tile v needs from cell c to its goal cell, 0 for the blank
+    struct DistanceTable {
+        uint8_t d[Board::CELLS][Board::CELLS];
+        constexpr DistanceTable() : d() {
+            for (int v = 1; v < Board::CELLS; ++v) {
+                for (int c = 0; c < Board::CELLS; ++c) {
+                    int dr = c / Board::COLS - (v - 1) / Board::COLS;
+                    int dc = c % Board::COLS - (v - 1) % Board::COLS;
+                    d[v][c] = (dr < 0 ? -dr : dr) + (dc < 0 ? -dc : dc);
+                }
+            }
+        }
+    };
+
+    static const DistanceTable DISTANCE;
+
+    // Goal row and column of every tile, and row and column of every cell,
+    // as byte lanes for full_ssse3. Lanes past the last cell stay 0.
+    struct LaneTables {
+        alignas(16) uint8_t goal_row[TILE_SLOTS];
+        alignas(16) uint8_t goal_col[TILE_SLOTS];
+        alignas(16) uint8_t cell_row[TILE_SLOTS];
+        alignas(16) uint8_t cell_col[TILE_SLOTS];
+        constexpr LaneTables() : goal_row(), goal_col(), cell_row(), cell_col() {
+            for (int v = 1; v < Board::CELLS; ++v) {
+                goal_row[v] = (v - 1) / Board::COLS;
+                goal_col[v] = (v - 1) % Board::COLS;
+            }
+            for (int c = 0; c < Board::CELLS; ++c) {
+                cell_row[c] = c / Board::COLS;
+                cell_col[c] = c % Board::COLS;
+            }
+        }
+    };
+
+    static const LaneTables LANES;
+
+    static int full_scalar(Tiles tiles) {
+        int MD = 0;
+        for (int c = 0; c < Board::CELLS; ++c)
+            MD += DISTANCE.d[(int)(tiles >> (TILE_BITS * c)) & TILE_MASK][c];
+        return MD;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Spread the 16 nibbles over 16 bytes, look up every tile's goal row and
+    // column with pshufb, and sum the absolute differences with psadbw. Only
+    // for boards of nibbles.
+    __attribute__((target("ssse3")))
+    static int full_ssse3(Tiles tiles) {
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+        const __m128i goal_row = _mm_load_si128((const __m128i *)LANES.goal_row);
+        const __m128i goal_col = _mm_load_si128((const __m128i *)LANES.goal_col);
+        const __m128i cell_row = _mm_load_si128((const __m128i *)LANES.cell_row);
+        const __m128i cell_col = _mm_load_si128((const __m128i *)LANES.cell_col);
+        __m128i packed = _mm_cvtsi64_si128((uint64_t)tiles);
+        __m128i t = _mm_unpacklo_epi8(_mm_and_si128(packed, nibble),
+                                      _mm_and_si128(_mm_srli_epi16(packed, 4), nibble));  // byte c = tile in cell c
+        __m128i dr = _mm_abs_epi8(_mm_sub_epi8(_mm_shuffle_epi8(goal_row, t), cell_row));
+        __m128i dc = _mm_abs_epi8(_mm_sub_epi8(_mm_shuffle_epi8(goal_col, t), cell_col));
+        __m128i zero = _mm_setzero_si128();
+        __m128i d = _mm_andnot_si128(_mm_cmpeq_epi8(t, zero), _mm_add_epi8(dr, dc));    // the blank adds nothing
+        __m128i sum = _mm_sad_epu8(d, zero);
+        return _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum, 4);
+    }
+
+    static int (*select_kernel())(Tiles) {
+        return TILE_BITS == 4 && __builtin_cpu_supports("ssse3") ? full_ssse3 : full_scalar;
+    }
+#else
+    static int (*select_kernel())(Tiles) {
+        return full_scalar;
+    }
+#endif
+
+    static inline int (*const full_kernel)(Tiles) = select_kernel();
+};
+
+const ManhattanDistance::DistanceTable ManhattanDistance::DISTANCE;
+const ManhattanDistance::LaneTables ManhattanDistance::LANES;
+
+//
+// Linear conflict correction:
+// Look at every line of the puzzle. If you find two tiles there which are supposed to end up in this line,
+// but which are currently in the wrong order, then you know that the Manhattan distance is too optimistic
+// and you actually need at least 2 more moves to get the two tiles past each other. More generally, of the
+// tiles in their goal line only a longest subsequence in goal order can stay; every other one has to leave
+// the line and come back, which costs 2 moves on top of its Manhattan distance. Row conflicts only cost
+// vertical moves and column conflicts only horizontal ones, so the corrections of all rows and columns add.
+//
+// The correction of every possible line is precomputed per row and per column. Up to 16 cells a line's key
+// is its tiles (4 bits per tile, see Board::row). Beyond, tiles of 5 bits would make tables of 2^25 entries,
+// so every cell adds 3 bits instead: 1 + the goal position in the line of a tile that belongs there, else 0.
+//
+class LinearConflictMD : public ManhattanDistance {
+    static const bool TILE_KEYS = TILE_BITS == 4;
+    static const int KEY_BITS = TILE_KEYS ? 4 : 3;
+
+    struct LineTables {
+        uint8_t row[Board::ROWS][1 << (KEY_BITS * Board::COLS)];
+        uint8_t col[Board::COLS][1 << (KEY_BITS * Board::ROWS)];
+        uint8_t row_digit[Board::ROWS][Board::CELLS];   // 3-bit keys: the digit of a tile in a row
+        uint8_t col_digit[Board::COLS][Board::CELLS];
+
+        // Goal position within the line of the tile behind digit d of a key, or -1
+        static int goal_in_row(int d, int line) {
+            if (!TILE_KEYS) return d - 1;
+            return d && d < Board::CELLS && (d - 1) / Board::COLS == line ? (d - 1) % Board::COLS : -1;
+        }
+
+        static int goal_in_col(int d, int line) {
+            if (!TILE_KEYS) return d - 1;
+            return d && d < Board::CELLS && (d - 1) % Board::COLS == line ? (d - 1) / Board::COLS : -1;
+        }
+
+        LineTables() {
+            const int DIGIT = (1 << KEY_BITS) - 1;
+            for (int key = 0; key < (1 << (KEY_BITS * Board::COLS)); ++key) {
+                for (int line = 0; line < Board::ROWS; ++line) {
+                    int goals[Board::COLS];
+                    int n = 0;
+                    for (int i = 0; i < Board::COLS; ++i) {
+                        int g = goal_in_row((key >> (KEY_BITS * i)) & DIGIT, line);
+                        if (g >= 0) goals[n++] = g;
+                    }
+                    row[line][key] = 2 * (n - longest_increasing(goals, n));
+                }
+            }
+            for (int key = 0; key < (1 << (KEY_BITS * Board::ROWS)); ++key) {
+                for (int line = 0; line < Board::COLS; ++line) {
+                    int goals[Board::ROWS];
+                    int n = 0;
+                    for (int i = 0; i < Board::ROWS; ++i) {
+                        int g = goal_in_col((key >> (KEY_BITS * i)) & DIGIT, line);
+                        if (g >= 0) goals[n++] = g;
+                    }
+                    col[line][key] = 2 * (n - longest_increasing(goals, n));
+                }
+            }
+            for (int t = 0; t < Board::CELLS; ++t) {
+                for (int line = 0; line < Board::ROWS; ++line)
+                    row_digit[line][t] = t && (t - 1) / Board::COLS == line ? (t - 1) % Board::COLS + 1 : 0;
+                for (int line = 0; line < Board::COLS; ++line)
+                    col_digit[line][t] = t && (t - 1) % Board::COLS == line ? (t - 1) / Board::COLS + 1 : 0;
+            }
+        }
+
+        static int longest_increasing(const int *goals, int n) {
+            int best = 0;
+            for (int subset = 0; subset < (1 << n); ++subset) {
+                int len = 0, last = -1;
+                bool increasing = true;
+                for (int i = 0; i < n && increasing; ++i) {
+                    if (!(subset & (1 << i))) continue;
+                    increasing = goals[i] > last;
+                    last = goals[i];
+                    ++len;
+                }
+                if (increasing) best = max(best, len);
+            }
+            return best;
+        }
+    };
+
+    static const LineTables TABLES;
+
+    static int row_key(const Board &b, int r) {
+        if (TILE_KEYS) return b.row(r);
+        int key = 0;
+        for (int j = 0; j < Board::COLS; ++j)
+            key |= TABLES.row_digit[r][b.get(r, j)] << (KEY_BITS * j);
+        return key;
+    }
+
+    static int col_key(const Board &b, int c) {
+        if (TILE_KEYS) return b.column(c);
+        int key = 0;
+        for (int i = 0; i < Board::ROWS; ++i)
+            key |= TABLES.col_digit[c][b.get(i, c)] << (KEY_BITS * i);
+        return key;
+    }
+
+    static int row_conflicts(const Board &b, int r) {
+        return TABLES.row[r][row_key(b, r)];
+    }
+
+    static int col_conflicts(const Board &b, int c) {
+        return TABLES.col[c][col_key(b, c)];
+    }
+
+public:
+    virtual int operator()(Board &b) {
+        int conflicts = 0;
+        for (int r = 0; r < Board::ROWS; ++r)
+            conflicts += row_conflicts(b, r);
+        for (int c = 0; c < Board::COLS; ++c)
+            conflicts += col_conflicts(b, c);
+        return ManhattanDistance::operator()(b) + conflicts;
+    }
+
+    // The blank does not count, so a horizontal move keeps every row's order
+    // and changes only the two columns it crosses, and vice versa.
+    virtual int update(Board &b, int s, int tile, int from, int to) {
+        Board parent = b;
+        parent.slide(to);
+        int delta;
+        if (from / Board::COLS == to / Board::COLS) {
+            int c1 = from % Board::COLS, c2 = to % Board::COLS;
+            delta = col_conflicts(b, c1) + col_conflicts(b, c2)
+                  - col_conflicts(parent, c1) - col_conflicts(parent, c2);
+        } else {
+            int r1 = from / Board::COLS, r2 = to / Board::COLS;
+            delta = row_conflicts(b, r1) + row_conflicts(b, r2)
+                  - row_conflicts(parent, r1) - row_conflicts(parent, r2);
+        }
+        return ManhattanDistance::update(b, s, tile, from, to) + delta;
+    }
+
+    virtual string get_name() {
+        return "MD + Linear Conflict Correction";
+    }
+};
+
+const LinearConflictMD::LineTables LinearConflictMD::TABLES;
+
+
+// Column major position of every cell, or with `inverse` the cell at every
+// column major position
+constexpr array<uint8_t, Board::CELLS> transposition(bool inverse) {
+    array<uint8_t, Board::CELLS> t{};
+    for (int c = 0; c < Board::CELLS; ++c) {
+        int p = c % Board::COLS * Board::ROWS + c / Board::COLS;
+        if (inverse) t[p] = c;
+        else t[c] = p;
+    }
+    return t;
+}
+
+//
+// The heuristic state keeps the horizontal and vertical inversion counts in
+// bits 8-16 and 17-25 (up to 276 on the 24-puzzle) so that a move only has to
+// recount the tiles the moved tile jumps over.
+//
+class InversionDistance : public Heuristic {
+    // A vertical move jumps COLS - 1 tiles in row major order, a horizontal
+    // one ROWS - 1 tiles in column major order.
+    static int pack(int h_inv, int v_inv) {
+        const int h_jump = Board::COLS - 1, v_jump = Board::ROWS - 1;
+        return ((h_inv + h_jump - 1) / h_jump + (v_inv + v_jump - 1) / v_jump) | (h_inv << 8) | (v_inv << 17);
+    }
+
+    // TRANSPOSE[c] is cell c's column major position, and tile x's goal
+    // position in column major order is TRANSPOSE[x - 1]. CELL_AT maps column
+    // major positions back to cells; on square boards the two are the same.
+    static constexpr array<uint8_t, Board::CELLS> TRANSPOSE = transposition(false);
+    static constexpr array<uint8_t, Board::CELLS> CELL_AT = transposition(true);
+
+    // Inversions of a sequence of distinct keys below 32: every key counts
+    // the larger keys before it with one popcount over the keys seen so far.
+    static inline __attribute__((always_inline)) int inversions(const int *keys, int n) {
+        int inv = 0;
+        uint32_t seen = 0;
+        for (int i = 0; i < n; ++i) {
+            inv += __builtin_popcount(seen >> keys[i]);
+            seen |= 1u << keys[i];
+        }
+        return inv;
+    }
+
+    static inline __attribute__((always_inline)) int count(Tiles tiles) {
+        Board b;
+        b.tiles = tiles;
+        int row_major[Board::CELLS], col_major[Board::CELLS];
+        int n = 0;
+        for (int c = 0; c < Board::CELLS; ++c) {
+            int x = b.get(c);
+            if (x) row_major[n++] = x - 1;      // ignore inversions with empty square
+        }
+        n = 0;
+        for (int p = 0; p < Board::CELLS; ++p) {
+            int x = b.get(CELL_AT[p]);
+            if (x) col_major[n++] = TRANSPOSE[x - 1];
+        }
+        return pack(inversions(row_major, n), inversions(col_major, n));
+    }
+
+    static int count_scalar(Tiles tiles) {
+        return count(tiles);
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Same code, compiled to use the popcnt instruction
+    __attribute__((target("popcnt")))
+    static int count_popcnt(Tiles tiles) {
+        return count(tiles);
+    }
+
+    static int (*select_kernel())(Tiles) {
+        return __builtin_cpu_supports("popcnt") ? count_popcnt : count_scalar;
+    }
+#else
+    static int (*select_kernel())(Tiles) {
+        return count_scalar;
+    }
+#endif
+
+    static inline int (*const count_kernel)(Tiles) = select_kernel();
+
+public:
+    virtual int operator()(Board &b) {
+        return value(init(b));
+    }
+
+    virtual int init(Board &b) {
+        return count_kernel(b.tiles);
+    }
+
+    // A vertical move jumps the tile over the cells between `from` and `to`
+    // in row major order and leaves the column major order untouched; a
+    // horizontal move does the same in column major order.
+    virtual int update(Board &b, int s, int tile, int from, int to) {
+        int h_inv = (s >> 8) & 0x1FF;
+        int v_inv = (s >> 17) & 0x1FF;
+        if (from / Board::COLS != to / Board::COLS) {
+            int step = to > from ? 1 : -1;
+            for (int c = from + step; c != to; c += step) {
+                int y = b.get(c);
+                h_inv += (y > tile) == (step > 0) ? 1 : -1;
+            }
+        } else {
+            int vt = TRANSPOSE[tile - 1];
+            int cm_from = TRANSPOSE[from], cm_to = TRANSPOSE[to];
+            int step = cm_to > cm_from ? 1 : -1;
+            for (int p = cm_from + step; p != cm_to; p += step) {
+                int vy = TRANSPOSE[b.get(CELL_AT[p]) - 1];
+                v_inv += (vy > vt) == (step > 0) ? 1 : -1;
+            }
+        }
+        return pack(h_inv, v_inv);
+    }
+
+    virtual string get_name() {
+        return "Inversion Distance";
+    }
+};
+
+
+//
+// Walking distance:
+// Forget which tile is which and keep, for every row, only how many of its
+// tiles belong in each goal row. A vertical move carries one tile into the
+// blank's row, so the fewest such moves from a board's counts to the goal's
+// is a lower bound on the vertical moves left. The same holds for columns and
+// horizontal moves, and the two bounds add.
+//
+// Each direction's distances are in a WalkTable indexed by the blank's line
+// and the rank of every line's counts, and built once by breadth-first search
+// over the reachable count tables (24964 on the 15-puzzle). Rows and columns
+// share a table on square boards, where the goal puts as many tiles of each
+// goal row in every row as tiles of each goal column in every column.
+//
+// The heuristic state keeps the vertical and horizontal distances in bits
+// 8-15 and 16-23, so a move only looks up the direction it moved in.
+//
+constexpr int binomial(int n, int k) {
+    return k == 0 ? 1 : binomial(n - 1, k - 1) * n / k;
+}
+
+constexpr uint64_t power(uint64_t b, int e) {
+    return e == 0 ? 1 : b * power(b, e - 1);
+}
+
+// Walks over L lines of W cells, with the blank in the last line at the goal
+template<int L, int W>
+class WalkTable {
+    static const int RANKS_FULL = binomial(W + L - 1, L - 1);   // ways to split W tiles over L goal lines
+    static const int CODES = power(W + 1, L);                   // count vectors of L digits 0..W
+
+    // Indexes run up to SIZE. Up to 2^24 of them every one gets a byte; past
+    // that, with five lines, only the reachable counts are kept, in an open
+    // addressed table: 66 million of the 5 * 126^4 indexes on the 24-puzzle.
+    static constexpr uint64_t SIZE = L * power(RANKS_FULL, L - 1);
+    static const bool DENSE = SIZE <= (1 << 24);
+    static_assert(SIZE < UINT32_MAX, "indexes must fit the sparse table's keys");
+
+    struct Counts {
+        uint8_t n[L][L];            // n[l][g]: tiles in line l whose goal line is g
+        int blank;                  // line holding the blank
+    };
+
+    vector<uint8_t> rank_by_code;   // by the counts as a base W + 1 number
+    vector<uint8_t> dist;           // moves by index(), or by slot of `keys`; 0xFF if unreachable
+    vector<uint32_t> keys;          // sparse tables: index + 1 in every used slot, else 0
+    size_t used = 0;
+
+    uint64_t index(const Counts &c) const {
+        int line_rank[L];
+        for (int l = 0; l < L; ++l)
+            line_rank[l] = rank(c.n[l]);
+        return index(line_rank, c.blank);
+    }
+
+    // Distance entry of idx, added as unreachable if new
+    uint8_t &entry(uint64_t idx) {
+        if (DENSE) return dist[idx];
+        if (2 * (used + 1) > keys.size()) {
+            vector<uint32_t> old_keys(2 * keys.size());
+            vector<uint8_t> old_dist(2 * keys.size(), 0xFF);
+            old_keys.swap(keys);
+            old_dist.swap(dist);
+            used = 0;
+            for (size_t i = 0; i < old_keys.size(); ++i)
+                if (old_keys[i]) entry(old_keys[i] - 1) = old_dist[i];
+        }
+        size_t mask = keys.size() - 1;
+        size_t i = SplitMix64::mix(idx) & mask;
+        for (; keys[i]; i = (i + 1) & mask)
+            if (keys[i] == idx + 1) return dist[i];
+        keys[i] = idx + 1;
+        ++used;
+        return dist[i];
+    }
+
+public:
+    // Moves from the counts with index idx to the goal's, 0xFF if unreachable
+    int distance(uint64_t idx) const {
+        if (DENSE) return dist[idx];
+        size_t mask = keys.size() - 1;
+        for (size_t i = SplitMix64::mix(idx) & mask; keys[i]; i = (i + 1) & mask)
+            if (keys[i] == idx + 1) return dist[i];
+        return 0xFF;
+    }
+
+    // Rank of a line's counts by goal line among those with the same total
+    template<class T>
+    int rank(const T *by_goal) const {
+        int code = 0;
+        for (int g = L - 1; g >= 0; --g)
+            code = code * (W + 1) + by_goal[g];
+        return rank_by_code[code];
+    }
+
+    // Every goal line has a fixed number of tiles, so the blank's line holds
+    // whatever the others leave and needs no digit
+    uint64_t index(const int *line_rank, int blank) const {
+        uint64_t idx = blank;
+        for (int l = 0; l < L; ++l)
+            if (l != blank) idx = idx * RANKS_FULL + line_rank[l];
+        return idx;
+    }
+
+    WalkTable() : rank_by_code(CODES) {
+        int next_rank[W + 1] = { 0 };
+        for (int code = 0; code < CODES; ++code) {
+            int total = 0;
+            for (int c = code; c; c /= W + 1)
+                total += c % (W + 1);
+            rank_by_code[code] = total <= W ? next_rank[total]++ : 0;
+        }
+        if (DENSE) {
+            dist.assign(SIZE, 0xFF);
+        } else {
+            keys.assign(1024, 0);
+            dist.assign(1024, 0xFF);
+        }
+
+        Counts goal = {};
+        for (int l = 0; l < L; ++l)
+            goal.n[l][l] = l == L - 1 ? W - 1 : W;
+        goal.blank = L - 1;
+        entry(index(goal)) = 0;
+        deque<Counts> queue{ goal };
+        while (!queue.empty()) {
+            Counts c = queue.front();
+            queue.pop_front();
+            int d = distance(index(c));
+            for (int l : { c.blank - 1, c.blank + 1 }) {
+                if (l < 0 || l >= L) continue;
+                for (int g = 0; g < L; ++g) {
+                    if (!c.n[l][g]) continue;
+                    Counts next = c;
+                    --next.n[l][g];
+                    ++next.n[c.blank][g];
+                    next.blank = l;
+                    uint8_t &e = entry(index(next));
+                    if (e == 0xFF) {
+                        e = d + 1;
+                        queue.push_back(next);
+                    }
+                }
+            }
+        }
+    }
+
+    static const WalkTable &get() {
+        static const WalkTable table;
+        return table;
+    }
+};
+
+class WalkingDistance : public Heuristic {
+    typedef WalkTable<Board::ROWS, Board::COLS> RowWalk;        // rows as lines: vertical moves
+    typedef WalkTable<Board::COLS, Board::ROWS> ColumnWalk;     // columns as lines: horizontal moves
+
+    const RowWalk &rows = RowWalk::get();
+    const ColumnWalk &cols = ColumnWalk::get();
+    vector<uint8_t> row_rank;       // rank of a row's counts by its key
+    vector<uint8_t> col_rank;       // rank of a column's counts by its key
+
+    // Up to 16 cells a line's key is its tiles (see Board::row). Beyond, every
+    // cell adds 3 bits, 1 + its tile's goal row (or column), 0 for the blank,
+    // which keeps the rank tables at 2^15 entries.
+    static const bool TILE_KEYS = TILE_BITS == 4;
+    static const int KEY_BITS = TILE_KEYS ? 4 : 3;
+
+    static int row_key(const Board &b, int r) {
+        if (TILE_KEYS) return b.row(r);
+        int key = 0;
+        for (int j = 0; j < Board::COLS; ++j)
+            key |= (b.get(r, j) + Board::COLS - 1) / Board::COLS << (KEY_BITS * j);
+        return key;
+    }
+
+    static int col_key(const Board &b, int c) {
+        if (TILE_KEYS) return b.column(c);
+        int key = 0;
+        for (int i = 0; i < Board::ROWS; ++i) {
+            int t = b.get(i, c);
+            key |= (t ? (t - 1) % Board::COLS + 1 : 0) << (KEY_BITS * i);
+        }
+        return key;
+    }
+
+    // Goal row or column of the tile behind digit d of a key, or -1
+    static int goal_line(int d, bool row) {
+        if (!TILE_KEYS) return d - 1;
+        if (!d || d >= Board::CELLS) return -1;
+        return row ? (d - 1) / Board::COLS : (d - 1) % Board::COLS;
+    }
+
+    static int pack(int v, int h) {
+        return (v + h) | (v << 8) | (h << 16);
+    }
+
+    int vertical(const Board &b) const {
+        int line_rank[Board::ROWS];
+        for (int r = 0; r < Board::ROWS; ++r)
+            line_rank[r] = row_rank[row_key(b, r)];
+        return rows.distance(rows.index(line_rank, b.i_cord()));
+    }
+
+    int horizontal(const Board &b) const {
+        int line_rank[Board::COLS];
+        for (int c = 0; c < Board::COLS; ++c)
+            line_rank[c] = col_rank[col_key(b, c)];
+        return cols.distance(cols.index(line_rank, b.j_cord()));
+    }
+
+public:
+    WalkingDistance() : row_rank(1 << (KEY_BITS * Board::COLS)), col_rank(1 << (KEY_BITS * Board::ROWS)) {
+        const int DIGIT = (1 << KEY_BITS) - 1;
+        for (int key = 0; key < (int)row_rank.size(); ++key) {
+            int by_goal_row[Board::ROWS] = { 0 };
+            for (int i = 0; i < Board::COLS; ++i) {
+                int g = goal_line((key >> (KEY_BITS * i)) & DIGIT, true);
+                if (g >= 0 && g < Board::ROWS) ++by_goal_row[g];
+            }
+            row_rank[key] = rows.rank(by_goal_row);
+        }
+        for (int key = 0; key < (int)col_rank.size(); ++key) {
+            int by_goal_col[Board::COLS] = { 0 };
+            for (int i = 0; i < Board::ROWS; ++i) {
+                int g = goal_line((key >> (KEY_BITS * i)) & DIGIT, false);
+                if (g >= 0 && g < Board::COLS) ++by_goal_col[g];
+            }
+            col_rank[key] = cols.rank(by_goal_col);
+        }
+    }
+
+    virtual int operator()(Board &b) {
+        return value(init(b));
+    }
+
+    virtual int init(Board &b) {
+        return pack(vertical(b), horizontal(b));
+    }
+
+    virtual int update(Board &b, int s, int tile, int from, int to) {
+        if (from / Board::COLS != to / Board::COLS)
+            return pack(vertical(b), (s >> 16) & 0xFF);
+        return pack((s >> 8) & 0xFF, horizontal(b));
+    }
+
+    virtual string get_name() {
+        return "Walking Distance";
+    }
+};
+
+
+/*****************************************
+ * Additive Pattern Database heuristic
+ *
+ * The tiles are split into disjoint groups.
+ * For each group a table holds the number
+ * of moves of that group's own tiles needed
+ * to bring them home, ignoring the identity
+ * of all other tiles. Since only the group's
+ * own moves are counted, the per-group values
+ * can be added and the sum stays admissible.
+ *
+ * The tables are built offline by generate()
+ * (pa2 --gen-pdb) and memory-mapped from disk
+ * by load(). Files are in native byte order.
+ *****************************************/
+class PatternDatabase : public Heuristic {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+    static const int MAX_GROUPS = 8;
+
+    struct FileHeader {
+        char magic[4];                                  // "PA2P"
+        uint32_t version;
+        uint32_t rows;
+        uint32_t cols;
+        uint32_t groups;
+        uint32_t group_size[MAX_GROUPS];
+        uint8_t group_tiles[MAX_GROUPS][Board::CELLS];
+        uint64_t group_offset[MAX_GROUPS];              // file offset of each group's table
+    };
+
+    // 6-6-3 partition of Korf & Felner on the 15-puzzle. Other sizes get
+    // runs of consecutive tiles: all of them up to the 8-puzzle, six up to 16
+    // cells and five beyond, where a group of six would search 25!/18! states.
+    static vector<vector<int>> default_groups() {
+        if (Board::ROWS == 4 && Board::COLS == 4)
+            return { { 1, 5, 6, 9, 10, 13 }, { 7, 8, 11, 12, 14, 15 }, { 2, 3, 4 } };
+        const int size = Board::CELLS <= 9 ? Board::CELLS - 1 : Board::CELLS <= 16 ? 6 : 5;
+        vector<vector<int>> groups;
+        for (int t = 1; t < Board::CELLS; ++t) {
+            if ((t - 1) % size == 0) groups.emplace_back();
+            groups.back().push_back(t);
+        }
+        return groups;
+    }
+
+    PatternDatabase() {}
+    PatternDatabase(const PatternDatabase &) = delete;
+    PatternDatabase& operator=(const PatternDatabase &) = delete;
+
+    ~PatternDatabase() {
+        if (map) munmap(map, map_len);
+    }
+
+    bool load(const string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << "Cannot open pattern database " << path << endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+            cerr << path << ": not a pattern database" << endl;
+            close(fd);
+            return false;
+        }
+        void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) {
+            cerr << "Cannot map pattern database " << path << endl;
+            return false;
+        }
+        if (map) munmap(map, map_len);
+        map = m;
+        map_len = st.st_size;
+
+        const FileHeader &hdr = *(const FileHeader *)map;
+        if (memcmp(hdr.magic, "PA2P", 4) != 0 || hdr.version != FORMAT_VERSION) {
+            cerr << path << ": unsupported pattern database format" << endl;
+            return false;
+        }
+        if (hdr.rows != Board::ROWS || hdr.cols != Board::COLS || hdr.groups > MAX_GROUPS) {
+            cerr << path << ": pattern database does not match the board" << endl;
+            return false;
+        }
+        fill(tile_group, tile_group + Board::CELLS, -1);
+        for (uint32_t g = 0; g < hdr.groups; ++g) {
+            int k = hdr.group_size[g];
+            if (k < 1 || k >= Board::CELLS || hdr.group_offset[g] + table_size(k) > map_len) {
+                cerr << path << ": corrupt pattern database" << endl;
+                return false;
+            }
+            for (int i = 0; i < k; ++i) {
+                int t = hdr.group_tiles[g][i];
+                if (t < 1 || t >= Board::CELLS || tile_group[t] >= 0) {
+                    cerr << path << ": corrupt pattern database" << endl;
+                    return false;
+                }
+                tile_group[t] = g;
+                tile_slot[t] = i;
+                group_tiles[g][i] = t;
+            }
+            group_size[g] = k;
+            table[g] = (const uint8_t *)map + hdr.group_offset[g];
+        }
+        groups = hdr.groups;
+        return true;
+    }
+
+    // Build the tables by a backward 0-1 breadth-first search from the goal
+    // over (group tile cells, blank cell), where only moves of group tiles
+    // cost 1, and write them to path.
+    static bool generate(const string &path, const vector<vector<int>> &partition) {
+        if (partition.size() > MAX_GROUPS) {
+            cerr << "Too many pattern groups" << endl;
+            return false;
+        }
+        FileHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, "PA2P", 4);
+        hdr.version = FORMAT_VERSION;
+        hdr.rows = Board::ROWS;
+        hdr.cols = Board::COLS;
+        hdr.groups = partition.size();
+        uint64_t offset = (sizeof(FileHeader) + 63) & ~63ULL;
+        for (size_t g = 0; g < partition.size(); ++g) {
+            hdr.group_size[g] = partition[g].size();
+            for (size_t i = 0; i < partition[g].size(); ++i)
+                hdr.group_tiles[g][i] = partition[g][i];
+            hdr.group_offset[g] = offset;
+            offset += table_size(partition[g].size());
+        }
+
+        ofstream out(path, ios::binary);
+        if (!out) {
+            cerr << "Cannot write " << path << endl;
+            return false;
+        }
+        out.write((const char *)&hdr, sizeof(hdr));
+        for (size_t g = 0; g < partition.size(); ++g) {
+            cout << "Building pattern group " << g << " (" << partition[g].size() << " tiles)" << endl;
+            vector<uint8_t> tbl = build_table(partition[g]);
+            out.seekp(hdr.group_offset[g]);
+            out.write((const char *)tbl.data(), tbl.size());
+        }
+        return (bool)out;
+    }
+
+    virtual int operator()(Board &b) {
+        int cell_of[Board::CELLS];
+        for (int c = 0; c < Board::CELLS; ++c)
+            cell_of[b.get(c)] = c;
+        int h = 0;
+        for (int g = 0; g < groups; ++g) {
+            int cells[Board::CELLS];
+            for (int i = 0; i < group_size[g]; ++i)
+                cells[i] = cell_of[group_tiles[g][i]];
+            h += table[g][perm_rank(cells, group_size[g])];
+        }
+        return h;
+    }
+
+    // Only the moved tile's group changes value. Tiles in no group are free
+    // to move; a partition need not cover the board.
+    virtual int update(Board &b, int s, int tile, int from, int to) {
+        int g = tile_group[tile];
+        if (g < 0) return s;
+        int cell_of[Board::CELLS];
+        for (int c = 0; c < Board::CELLS; ++c)
+            cell_of[b.get(c)] = c;
+        int cells[Board::CELLS];
+        for (int i = 0; i < group_size[g]; ++i)
+            cells[i] = cell_of[group_tiles[g][i]];
+        int child = table[g][perm_rank(cells, group_size[g])];
+        cells[tile_slot[tile]] = from;
+        int parent = table[g][perm_rank(cells, group_size[g])];
+        return s - parent + child;
+    }
+
+    virtual string get_name() {
+        string name = "Additive PDB ";
+        for (int g = 0; g < groups; ++g)
+            name += (g ? "-" : "") + to_string(group_size[g]);
+        return name;
+    }
+
+private:
+    int groups = 0;
+    int group_size[MAX_GROUPS];
+    int group_tiles[MAX_GROUPS][Board::CELLS];
+    const uint8_t *table[MAX_GROUPS];
+    int tile_group[Board::CELLS];
+    int tile_slot[Board::CELLS];
+    void *map = nullptr;
+    size_t map_len = 0;
+
+    // number of ways to place k distinct tiles on the board
+    static uint64_t table_size(int k) {
+        uint64_t n = 1;
+        for (int i = 0; i < k; ++i)
+            n *= Board::CELLS - i;
+        return n;
+    }
+
+    static vector<uint8_t> build_table(const vector<int> &tiles) {
+        const int k = tiles.size();
+        const int free_cells = Board::CELLS - k;
+        vector<uint8_t> dist(table_size(k + 1), 0xFF);
+        deque<uint32_t> queue;
+
+        int cells[Board::CELLS];
+        for (int i = 0; i < k; ++i)
+            cells[i] = tiles[i] - 1;
+        cells[k] = Board::CELLS - 1;
+        uint32_t start = perm_rank(cells, k + 1);
+        dist[start] = 0;
+        queue.push_back(start);
+
+        static const int dr[] = { -1, 1, 0, 0 };
+        static const int dc[] = { 0, 0, -1, 1 };
+        while (!queue.empty()) {
+            uint32_t idx = queue.front();
+            queue.pop_front();
+            int d = dist[idx];
+            perm_unrank(idx, cells, k + 1);
+            int occ[Board::CELLS];
+            fill(occ, occ + Board::CELLS, -1);
+            for (int i = 0; i < k; ++i)
+                occ[cells[i]] = i;
+
+            int blank = cells[k];
+            for (int a = 0; a < 4; ++a) {
+                int r = blank / Board::COLS + dr[a];
+                int c = blank % Board::COLS + dc[a];
+                if (r < 0 || r >= Board::ROWS || c < 0 || c >= Board::COLS) continue;
+                int nb = r * Board::COLS + c;
+                int slot = occ[nb];
+                int cost = slot >= 0 ? 1 : 0;
+                if (slot >= 0) cells[slot] = blank;
+                cells[k] = nb;
+                uint32_t next = perm_rank(cells, k + 1);
+                if (dist[next] > d + cost) {
+                    dist[next] = d + cost;
+                    if (cost) queue.push_back(next);
+                    else queue.push_front(next);
+                }
+                if (slot >= 0) cells[slot] = nb;
+                cells[k] = blank;
+            }
+        }
+
+        // the blank is the last, radix (CELLS - k) digit: minimize over it
+        vector<uint8_t> tbl(table_size(k), 0xFF);
+        for (size_t i = 0; i < dist.size(); ++i)
+            tbl[i / free_cells] = min(tbl[i / free_cells], dist[i]);
+        return tbl;
+    }
+};
+
+
+/*****************************************
+ * Transposition table for IDA*
+ *
+ * Maps (board, previous move) to a lower
+ * bound on the remaining moves to the goal,
+ * backed up from an earlier failed search
+ * of that node. The previous move is part
+ * of the key because the searches never undo
+ * it, so a bound only holds for arrivals by
+ * the same move. Only entries of the current
+ * search are used: a bound is only as good
+ * as the heuristic it was backed up from.
+ *
+ * Buckets hold two entries: the first keeps
+ * the shallowest node of the current search
+ * (the largest subtree), the second is
+ * always replaced. Not thread safe; use one
+ * table per thread.
+ *****************************************/
+class TranspositionTable {
+public:
+    struct Stats {
+        long probes = 0;
+        long hits = 0;      // probes that found their entry
+        long cutoffs = 0;   // nodes pruned by a bound that h alone would have expanded
+    };
+
+    Stats stats;
+
+    explicit TranspositionTable(size_t megabytes) {
+        size_t n = 1;
+        while (2 * n * sizeof(Bucket) <= (megabytes << 20)) n *= 2;
+        buckets.resize(n);
+        mask = n - 1;
+    }
+
+    // Start a new search; entries of earlier ones become free slots.
+    void new_search() { ++age; }
+
+    // Stored bound for b reached by `last`, or 0
+    int bound(const Board &b, Board::Action last) {
+        ++stats.probes;
+        Bucket &bk = bucket(b, last);
+        for (Entry &e : bk.e) {
+            if (e.tiles == b.tiles && e.last == last && e.age == age) {
+                ++stats.hits;
+                return e.bound;
+            }
+        }
+        return 0;
+    }
+
+    void store(const Board &b, Board::Action last, int g, int bound) {
+        Bucket &bk = bucket(b, last);
+        Entry e{ b.tiles, (uint8_t)last, (uint8_t)min(g, 255), (uint8_t)min(bound, 255), age };
+        Entry &deep = bk.e[0];
+        if (deep.tiles == b.tiles && deep.last == last && deep.age == age) {
+            deep.bound = max(deep.bound, e.bound);
+            deep.g = min(deep.g, e.g);
+        } else if (deep.age != age || e.g <= deep.g) {
+            if (deep.age == age) bk.e[1] = deep;    // demote, it is still worth keeping
+            deep = e;
+        } else {
+            bk.e[1] = e;
+        }
+    }
+
+private:
+    struct Entry {
+        Tiles tiles;        // 0 (never a valid board) marks an empty entry
+        uint8_t last;
+        uint8_t g;
+        uint8_t bound;
+        uint32_t age;
+    };
+
+    struct Bucket {
+        Entry e[2];
+    };
+
+    vector<Bucket> buckets;
+    size_t mask;
+    uint32_t age = 0;
+
+    Bucket& bucket(const Board &b, Board::Action last) {
+        return buckets[(hash<Board>()(b) + last * 0x9E3779B9u) & mask];
+    }
+};
+
+
+/*****************************************
+ * Duplicate move pruning for IDA*
+ *
+ * After Taylor and Korf: a search over
+ * strings of blank moves, shortest first
+ * and then in alphabetical order, finds the
+ * strings that have the same effect as an
+ * earlier one. Those are compiled into an
+ * automaton that IDA* carries down the tree
+ * and that rejects any move completing one.
+ * The least string reaching a state never
+ * contains a duplicate, since swapping the
+ * duplicate for its earlier twin would give
+ * a lesser one, so no optimal path is lost.
+ *****************************************/
+class MovePruner {
+public:
+    static const int MAX_DEPTH = 14;
+
+    // Learn the duplicates of up to `depth` moves. The strings are played on
+    // an unbounded grid, so they hold for every board size. An earlier string
+    // only counts as a twin if its blank stays within the rows and columns
+    // this one's visits, which makes it applicable wherever this one is.
+    // Strings of each length are enumerated with the automaton built from
+    // the shorter duplicates, so none containing one is ever extended.
+    explicit MovePruner(int depth) {
+        Learner l(depth);
+        for (int k = 1; k <= depth; ++k) {
+            build(l.found);
+            l.search(*this, k, 0, 0, 0, 0, l.start_box());
+        }
+        build(l.found);
+    }
+
+    // Automaton state after `state` and move a, or -1 if the move completes
+    // a duplicate string. The start state is 0.
+    int next(int state, Board::Action a) const {
+        return delta[state][a];
+    }
+
+    size_t duplicates() const { return patterns; }
+    size_t states() const { return delta.size(); }
+
+private:
+    vector<array<int, 4>> delta;
+    size_t patterns = 0;
+
+    // Depth-first enumeration of the strings of one length, on a window
+    // large enough that the blank never leaves it. A cell holds the cell its
+    // occupant started in; a string's effect is keyed by a hash of the cells
+    // whose occupant has changed. Strings kept so far are in an open
+    // addressing table of (effect, box), where a zero box marks a free slot.
+    struct Learner {
+        struct Kept {
+            uint64_t effect;
+            uint32_t box;
+        };
+
+        int width;
+        vector<int> grid;
+        int blank;
+        vector<Kept> kept;
+        size_t kept_count = 0;
+        vector<vector<int>> found;
+
+        explicit Learner(int depth) : width(2 * depth + 1), grid(width * width), kept(1024) {
+            for (int c = 0; c < width * width; ++c)
+                grid[c] = c;
+            blank = width * width / 2;
+            keep(0, start_box());
+        }
+
+        // Rows and columns visited, packed as four bytes: lowest and highest
+        // column, lowest and highest row. The highest column is never zero.
+        uint32_t start_box() const {
+            int x = blank % width, y = blank / width;
+            return x | x << 8 | y << 16 | (uint32_t)y << 24;
+        }
+
+        static bool inside(uint32_t in, uint32_t out) {
+            return (in & 0xFF) >= (out & 0xFF) && (in >> 8 & 0xFF) <= (out >> 8 & 0xFF)
+                && (in >> 16 & 0xFF) >= (out >> 16 & 0xFF) && (in >> 24) <= (out >> 24);
+        }
+
+        static uint64_t occupant(int cell, int from) {
+            return SplitMix64::mix((uint64_t)cell << 32 | from) ^ SplitMix64::mix((uint64_t)cell << 32 | cell);
+        }
+
+        size_t slot(uint64_t effect) const {
+            return SplitMix64::mix(effect) & (kept.size() - 1);
+        }
+
+        void keep(uint64_t effect, uint32_t box) {
+            if (2 * (kept_count + 1) > kept.size()) {
+                vector<Kept> old(2 * kept.size());
+                old.swap(kept);
+                kept_count = 0;
+                for (Kept &k : old)
+                    if (k.box) keep(k.effect, k.box);
+            }
+            size_t i = slot(effect);
+            while (kept[i].box)
+                i = (i + 1) & (kept.size() - 1);
+            kept[i] = { effect, box };
+            ++kept_count;
+        }
+
+        // Whether a string kept earlier has this effect within this box
+        bool twin(uint64_t effect, uint32_t box) const {
+            for (size_t i = slot(effect); kept[i].box; i = (i + 1) & (kept.size() - 1))
+                if (kept[i].effect == effect && inside(kept[i].box, box)) return true;
+            return false;
+        }
+
+        // Extend a string of `length` moves, in automaton state `state`, to
+        // `target` moves
+        void search(const MovePruner &pruner, int target, int length, int state, uint64_t moves, uint64_t effect,
+                    uint32_t box) {
+            if (length == target) {
+                if (!twin(effect, box)) {
+                    keep(effect, box);
+                    return;
+                }
+                vector<int> s(length);
+                for (int i = 0; i < length; ++i)
+                    s[i] = moves >> (2 * (length - 1 - i)) & 3;
+                found.push_back(s);
+                return;
+            }
+            const int offset[] = { -width, width, -1, 1 };
+            for (int a = 0; a < 4; ++a) {
+                int q = pruner.next(state, Board::Action(a));
+                if (q < 0) continue;
+                int from = blank, to = blank + offset[a];
+                uint64_t e = effect ^ occupant(from, grid[from]) ^ occupant(to, grid[to]);
+                swap(grid[from], grid[to]);
+                e ^= occupant(from, grid[from]) ^ occupant(to, grid[to]);
+                blank = to;
+                int x = to % width, y = to / width;
+                uint32_t b = min<uint32_t>(box & 0xFF, x) | max<uint32_t>(box >> 8 & 0xFF, x) << 8
+                           | min<uint32_t>(box >> 16 & 0xFF, y) << 16 | max<uint32_t>(box >> 24, y) << 24;
+                search(pruner, target, length + 1, q, moves << 2 | a, e, b);
+                blank = from;
+                swap(grid[from], grid[to]);
+            }
+        }
+    };
+
+    // Aho-Corasick automaton over the duplicates. A state is dead if it or
+    // one of its suffixes ends a duplicate; moves into dead states are -1.
+    void build(const vector<vector<int>> &strings) {
+        patterns = strings.size();
+        vector<array<int, 4>> go(1, array<int, 4>{ { -1, -1, -1, -1 } });
+        vector<bool> dead(1, false);
+        for (const vector<int> &s : strings) {
+            int q = 0;
+            for (int a : s) {
+                if (go[q][a] < 0) {
+                    go[q][a] = go.size();
+                    go.push_back(array<int, 4>{ { -1, -1, -1, -1 } });
+                    dead.push_back(false);
+                }
+                q = go[q][a];
+            }
+            dead[q] = true;
+        }
+        vector<int> fail(go.size(), 0);
+        deque<int> queue;
+        for (int a = 0; a < 4; ++a) {
+            if (go[0][a] < 0) go[0][a] = 0;
+            else queue.push_back(go[0][a]);
+        }
+        while (!queue.empty()) {
+            int q = queue.front();
+            queue.pop_front();
+            dead[q] = dead[q] || dead[fail[q]];
+            for (int a = 0; a < 4; ++a) {
+                int r = go[q][a];
+                if (r < 0) {
+                    go[q][a] = go[fail[q]][a];
+                } else {
+                    fail[r] = go[fail[q]][a];
+                    queue.push_back(r);
+                }
+            }
+        }
+        delta = go;
+        for (auto &row : delta)
+            for (int &q : row)
+                if (dead[q]) q = -1;
+    }
+};
+
+
+/*****************************************
+ * Search statistics
+ *
+ * Build with -DPA2_STATS to record where
+ * each solve spends its effort. Without
+ * it every STAT() is compiled out of the
+ * searches.
+ *****************************************/
+// TIMED(stats, field, statement) also adds the ticks the statement took to
+// stats->field.
+#ifdef PA2_STATS
+#define STAT(...) __VA_ARGS__
+#define TIMED(stats, field, ...) \
+    do { uint64_t t0_ = ticks(); __VA_ARGS__; if (stats) (stats)->field += ticks() - t0_; } while (0)
+#else
+#define STAT(...)
+#define TIMED(stats, field, ...) do { __VA_ARGS__; } while (0)
+#endif
+
+struct SearchStats {
+    vector<long> iteration_nodes;   // nodes expanded by each f_limit iteration of IDA*
+    long reexpansions = 0;          // RBFS subtrees searched again after being given up
+    int max_depth = 0;
+    uint64_t heuristic_ticks = 0;   // applying moves, which updates h
+    uint64_t hash_ticks = 0;        // transposition table probes and stores
+    uint64_t successor_ticks = 0;   // generating actions
+    long long cycles = -1;          // hardware counters, -1 when unavailable
+    long long cache_misses = -1;
+    long long branch_misses = -1;
+};
+
+// Cheap timestamp for the tick counters: the TSC where there is one.
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+#ifdef PA2_STATS
+// Cycle, cache miss and branch miss counters for the calling thread, read
+// around one solve. Counters the kernel refuses to open stay at -1.
+class PerfCounters {
+    int fd[3] = { -1, -1, -1 };
+public:
+    explicit PerfCounters(bool open) {
+#ifdef __linux__
+        if (!open) return;
+        const uint64_t config[3] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES,
+                                     PERF_COUNT_HW_BRANCH_MISSES };
+        for (int i = 0; i < 3; ++i) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+        for (int f : fd)
+            if (f >= 0) close(f);
+    }
+
+    void start() {
+#ifdef __linux__
+        for (int f : fd)
+            if (f >= 0) {
+                ioctl(f, PERF_EVENT_IOC_RESET, 0);
+                ioctl(f, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+    }
+
+    void stop(SearchStats &s) {
+        long long *out[3] = { &s.cycles, &s.cache_misses, &s.branch_misses };
+        for (int i = 0; i < 3; ++i) {
+            if (fd[i] < 0) continue;
+#ifdef __linux__
+            ioctl(fd[i], PERF_EVENT_IOC_DISABLE, 0);
+#endif
+            long long count;
+            if (read(fd[i], &count, sizeof(count)) == sizeof(count)) *out[i] = count;
+        }
+    }
+};
+#endif
+
+
+/*****************************************
+ * Search budgets
+ *
+ * A SearchBudget stops a solve once it has
+ * expanded too many nodes, passed its
+ * deadline, or been cancelled from another
+ * thread. The searches poll it every POLL
+ * nodes and unwind once it is spent. Anytime
+ * IDA* and MM then return the best solution
+ * found so far, the others none; all leave
+ * a proven lower bound on the optimal
+ * length in the budget.
+ *****************************************/
+struct SearchLimits {
+    long max_nodes = 0;         // 0 for no limit
+    long max_ms = 0;
+
+    bool any() const { return max_nodes || max_ms; }
+};
+
+class SearchBudget {
+public:
+    static const int POLL = 1024;   // nodes between polls; a power of two
+    int lower_bound = 0;            // set by the search when it returns
+
+    explicit SearchBudget(const SearchLimits &limits)
+        : max_nodes(limits.max_nodes ? limits.max_nodes : LONG_MAX),
+          deadline(limits.max_ms ? chrono::steady_clock::now() + chrono::milliseconds(limits.max_ms)
+                                 : chrono::steady_clock::time_point::max()) {}
+
+    // Safe to call from any thread; the search stops at its next poll.
+    void cancel() { stopped.store(true, memory_order_relaxed); }
+
+    bool exhausted() const { return stopped.load(memory_order_relaxed); }
+
+    // For the searches, with their own count of nodes expanded. Every thread
+    // of a parallel search adds POLL per poll, so the node limit holds to
+    // within POLL per thread.
+    bool spent(int nodes_expanded) {
+        if ((nodes_expanded & (POLL - 1)) == 0 && !exhausted()) {
+            if (nodes.fetch_add(POLL, memory_order_relaxed) + POLL >= max_nodes
+                || chrono::steady_clock::now() >= deadline)
+                cancel();
+        }
+        return exhausted();
+    }
+
+    // For nodes that spent() never saw: a parallel search counts every task
+    // from zero and charges what is left below POLL when the task finishes.
+    void charge(long n) {
+        if (nodes.fetch_add(n, memory_order_relaxed) + n >= max_nodes || chrono::steady_clock::now() >= deadline)
+            cancel();
+    }
+
+private:
+    long max_nodes;
+    chrono::steady_clock::time_point deadline;
+    atomic<long> nodes{ 0 };
+    atomic<bool> stopped{ false };
+};
+
+
+/*****************************************
+ * Problem class
+ *
+ * Contains the heuristic, successor, and
+ * goal_test functions. Also contains a
+ * scramble function, that generates
+ * solvable starting states, and print
+ * function that prints a sequence of board
+ * states.
+ *****************************************/
+class Problem {
+    mt19937 randgen;
+public:
+    Heuristic &h;
+    TranspositionTable *tt = nullptr;   // used by IDA* when set
+    SearchStats *stats = nullptr;       // filled in by IDA* and RBFS when set, in PA2_STATS builds
+    SearchBudget *budget = nullptr;     // bounds the searches when set
+    const MovePruner *pruner = nullptr; // prunes duplicate move strings in IDA* when set
+
+    Problem(Heuristic &h) : randgen(), h(h) {}
+    Problem(Heuristic &h, seed_seq &seed) : randgen(seed), h(h) {}
+
+    // Applicable actions in b, except the one undoing `last`. Returns how
+    // many were written to out, which must have room for four.
+    static int actions(const Board &b, Board::Action last, Board::Action *out) {
+        Board::Action back = Board::inverse(last);
+        int n = 0;
+        if (b.i_cord() > 0 && back != Board::UP)    out[n++] = Board::UP;
+        if (b.i_cord() < Board::ROWS - 1 && back != Board::DOWN)  out[n++] = Board::DOWN;
+        if (b.j_cord() > 0 && back != Board::LEFT)  out[n++] = Board::LEFT;
+        if (b.j_cord() < Board::COLS - 1 && back != Board::RIGHT) out[n++] = Board::RIGHT;
+        return n;
+    }
+
+    // Make/unmake moves for the searches: apply() changes b in place and
+    // updates its heuristic state, undo() restores the parent's.
+    void apply(Board &b, Board::Action a) {
+        int to = b.blank;
+        int from = b.target(a);
+        int tile = b.get(from);
+        b.slide(from);
+        b.H = h.update(b, b.H, tile, from, to);
+    }
+
+    void undo(Board &b, Board::Action a, int parent_H) {
+        b.slide(b.target(Board::inverse(a)));
+        b.H = parent_H;
+    }
+
+    // apply() and init() for a heuristic whose concrete type H is known at
+    // compile time. The qualified calls bypass virtual dispatch, so the
+    // searches instantiated for H can inline the heuristic.
+    template<class H>
+    void apply(Board &b, Board::Action a) {
+        static_assert(!is_abstract<H>::value, "H must be a concrete heuristic");
+        int to = b.blank;
+        int from = b.target(a);
+        int tile = b.get(from);
+        b.slide(from);
+        b.H = static_cast<H &>(h).H::update(b, b.H, tile, from, to);
+    }
+
+    template<class H>
+    int init(Board &b) {
+        return static_cast<H &>(h).H::init(b);
+    }
+
+    // Board sequence from start along moves
+    vector<Board> replay(Board start, const vector<Board::Action> &moves) {
+        vector<Board> path{ start };
+        for (Board::Action a : moves) {
+            apply(start, a);
+            path.push_back(start);
+        }
+        return path;
+    }
+
+    // Blank moves along a path as a string of U, D, L and R
+    string moves_string(const vector<Board> &path) {
+        string s;
+        for (size_t i = 1; i < path.size(); ++i) {
+            int d = path[i].blank - path[i - 1].blank;
+            s += d == -Board::COLS ? 'U' : d == Board::COLS ? 'D' : d == -1 ? 'L' : 'R';
+        }
+        return s;
+    }
+
+    vector<Board> successors(Board &b) {
+        vector<Board> succ;
+        if (b.i_cord() > 0) succ.emplace_back(b, Board::UP);
+        if (b.i_cord() < Board::ROWS - 1) succ.emplace_back(b, Board::DOWN);
+        if (b.j_cord() > 0) succ.emplace_back(b, Board::LEFT);
+        if (b.j_cord() < Board::COLS - 1) succ.emplace_back(b, Board::RIGHT);
+        return succ;
+    }
+
+    bool goal_test(Board &b) {
+        return b.tiles == Board::GOAL;
+    }
+
+    // Random walk of m moves from the goal, as the experiment has always
+    // drawn its boards. Steps may undo the previous one, so the board is
+    // often much closer than m; the instance corpus does not backtrack.
+    Board scramble(int m) {
+        Board b;
+        Board::Action a[4];
+        for (int i = 0; i < m; ++i) {
+            int n = actions(b, Board::NONE, a);
+            b = Board(b, a[randgen() % n]);
+        }
+        return b;
+    }
+
+    void print(vector<Board> &path) {
+        for (Board &b : path) {
+            b.print();
+            cout << endl;
+        }
+    }
+};
+
+// Debugging helper function
+void pause(Board &b, Problem &p, int f) {
+    b.print();
+    cout << "h: " << p.h(b) << ", f: " << f << endl << "paused..." << endl << endl;
+    string s;
+    getline(cin, s);
+}
+
+/*****************************************
+ * Work-stealing thread pool
+ *
+ * Every worker owns a deque of tasks. It
+ * pops from the back of its own deque and,
+ * once that runs dry, steals from the front
+ * of the others'. Tasks submitted by a worker
+ * go onto that worker's own deque.
+ *****************************************/
+class WorkStealingPool {
+public:
+    typedef function<void(int)> Task;   // called with the worker's index
+
+    explicit WorkStealingPool(int threads = 0)
+        : threads(threads > 0 ? threads : max(1u, thread::hardware_concurrency())),
+          queues(new Queue[this->threads]) {
+        workers.reserve(this->threads);
+        for (int i = 0; i < this->threads; ++i)
+            workers.emplace_back(&WorkStealingPool::run, this, i);
+    }
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        work_cv.notify_all();
+        for (thread &t : workers)
+            t.join();
+    }
+
+    // Fixed before the first worker starts; the workers never read `workers`,
+    // which is still growing while they run.
+    int size() const { return threads; }
+
+    void submit(Task task) {
+        int w = current_pool == this ? current_worker : next_queue++ % size();
+        {
+            lock_guard<mutex> lock(queues[w].m);
+            queues[w].tasks.push_back(move(task));
+        }
+        {
+            lock_guard<mutex> lock(m);
+            ++queued;
+            ++unfinished;
+        }
+        work_cv.notify_one();
+    }
+
+    // Block until every submitted task has finished. Not for use by workers.
+    void wait() {
+        unique_lock<mutex> lock(m);
+        done_cv.wait(lock, [this] { return unfinished == 0; });
+    }
+
+private:
+    struct Queue {
+        mutex m;
+        deque<Task> tasks;
+    };
+
+    const int threads;
+    unique_ptr<Queue[]> queues;
+    vector<thread> workers;
+    mutex m;                    // guards the counters below; never held while taking a queue lock
+    condition_variable work_cv;
+    condition_variable done_cv;
+    long queued = 0;
+    long unfinished = 0;
+    bool stopping = false;
+    atomic<unsigned> next_queue{ 0 };
+
+    static thread_local WorkStealingPool *current_pool;
+    static thread_local int current_worker;
+
+    bool pop(int id, Task &task) {
+        for (int i = 0; i < size(); ++i) {
+            Queue &q = queues[(id + i) % size()];
+            lock_guard<mutex> qlock(q.m);
+            if (q.tasks.empty()) continue;
+            if (i == 0) {
+                task = move(q.tasks.back());
+                q.tasks.pop_back();
+            } else {
+                task = move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+            lock_guard<mutex> lock(m);
+            --queued;
+            return true;
+        }
+        return false;
+    }
+
+    void run(int id) {
+        current_pool = this;
+        current_worker = id;
+        while (true) {
+            Task task;
+            if (!pop(id, task)) {
+                unique_lock<mutex> lock(m);
+                work_cv.wait(lock, [this] { return stopping || queued > 0; });
+                if (stopping && queued == 0) return;
+                continue;
+            }
+            task(id);
+            lock_guard<mutex> lock(m);
+            if (--unfinished == 0) done_cv.notify_all();
+        }
+    }
+};
+
+thread_local WorkStealingPool *WorkStealingPool::current_pool = nullptr;
+thread_local int WorkStealingPool::current_worker = 0;
+
+// Lets a thread wait for a fixed number of tasks to finish without waiting
+// for everything else running on the pool.
+class CountdownLatch {
+    mutex m;
+    condition_variable cv;
+    size_t count;
+public:
+    explicit CountdownLatch(size_t count) : count(count) {}
+
+    void count_down() {
+        lock_guard<mutex> lock(m);
+        if (--count == 0) cv.notify_all();
+    }
+
+    void wait() {
+        unique_lock<mutex> lock(m);
+        cv.wait(lock, [this] { return count == 0; });
+    }
+};
+
+// Blocking FIFO holding at most `capacity` items. pop() returns false once
+// the queue is closed and drained.
+template<class T>
+class BoundedQueue {
+    mutex m;
+    condition_variable not_full;
+    condition_variable not_empty;
+    deque<T> items;
+    size_t capacity;
+    bool closed = false;
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(T item) {
+        unique_lock<mutex> lock(m);
+        not_full.wait(lock, [this] { return items.size() < capacity; });
+        items.push_back(move(item));
+        not_empty.notify_one();
+    }
+
+    bool pop(T &item) {
+        unique_lock<mutex> lock(m);
+        not_empty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        item = move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        not_empty.notify_all();
+    }
+};
+
+
+/*************************
+ * IDA* Search Algorithm *
+ *************************/
+// The search moves b in place and keeps the moves from the start on `moves`.
+// Cycles are cut by never undoing the previous move and, with a pruner, by
+// skipping moves that complete a duplicate string; `state` is the pruner's
+// state after `moves`.
+template<class H>
+int DL_A_star(Board &b, vector<Board::Action> &moves, Problem &p, int g, int f_limit, int state,
+              int &nodes_expanded, const atomic<bool> *stop = nullptr) {
+    if (stop && stop->load(memory_order_relaxed)) return INT_MAX;  // cancelled by another worker
+    Board::Action last = moves.empty() ? Board::NONE : moves.back();
+    int f = g + Heuristic::value(b.H);
+    ++nodes_expanded;
+    if (p.budget && p.budget->spent(nodes_expanded)) return INT_MAX;
+    STAT(if (p.stats && (int)moves.size() > p.stats->max_depth) p.stats->max_depth = moves.size();)
+    //pause(b, p, f);
+    if (f > f_limit) return f;
+    if (p.tt) {
+        int f_tt;
+        TIMED(p.stats, hash_ticks, f_tt = g + p.tt->bound(b, last));
+        if (f_tt > f_limit) {
+            ++p.tt->stats.cutoffs;
+            return f_tt;
+        }
+    }
+    if (p.goal_test(b)) return f;
+    int f_min = INT_MAX;
+    int parent_H = b.H;
+    Board::Action acts[4];
+    int n;
+    TIMED(p.stats, successor_ticks, n = p.actions(b, last, acts));
+    for (int i = 0; i < n; ++i) {
+        int child_state = 0;
+        if (p.pruner && (child_state = p.pruner->next(state, acts[i])) < 0) continue;
+        TIMED(p.stats, heuristic_ticks, p.apply<H>(b, acts[i]));
+        moves.push_back(acts[i]);
+        f = DL_A_star<H>(b, moves, p, g + 1, f_limit, child_state, nodes_expanded, stop);
+        if (f <= f_limit) return f; // if goal is found, return length
+        if (f < f_min) f_min = f;   // if smallest over limit, update f_min
+        moves.pop_back();
+        p.undo(b, acts[i], parent_H);
+    }
+    if (p.tt && f_min != INT_MAX) TIMED(p.stats, hash_ticks, p.tt->store(b, last, g, f_min - g));
+    return f_min;                       // return smallest over limit
+}
+
+template<class H>
+vector<Board> ID_A_star(Board &start, Problem &p, int &nodes_expanded) {
+    start.H = p.init<H>(start);
+    int f_limit = Heuristic::value(start.H);
+    Board b = start;
+    vector<Board::Action> moves;
+    moves.reserve(128);
+    if (p.tt) p.tt->new_search();
+    while (1) {
+        STAT(int before = nodes_expanded;)
+        int f_min = DL_A_star<H>(b, moves, p, 0, f_limit, 0, nodes_expanded);
+        STAT(if (p.stats) p.stats->iteration_nodes.push_back(nodes_expanded - before);)
+        if (f_min <= f_limit) {                                 // if goal is found, return path
+            if (p.budget) p.budget->lower_bound = moves.size();
+            return p.replay(start, moves);
+        }
+        if (p.budget && p.budget->exhausted()) {                // out of budget, every shorter limit failed
+            p.budget->lower_bound = f_limit;
+            return vector<Board>();
+        }
+        if (f_min == INT_MAX) return vector<Board>();           // if failure, return empty path
+        f_limit = f_min;
+    }
+}
+
+/**********************************
+ * Parallel IDA* Search Algorithm *
+ **********************************/
+// Walk the f_limit-bounded tree down to `depth` and collect the moves to the
+// nodes there as independent subtrees. Returns like DL_A_star, except that
+// frontier nodes within the limit are left for the workers to search.
+template<class H>
+int DL_frontier(Board &b, vector<Board::Action> &moves, Problem &p, int g, int f_limit, int state, int depth,
+                vector<vector<Board::Action>> &frontier, int &nodes_expanded) {
+    int f = g + Heuristic::value(b.H);
+    if (f <= f_limit && depth == 0) {
+        frontier.push_back(moves);
+        return INT_MAX;
+    }
+    ++nodes_expanded;
+    if (p.budget && p.budget->spent(nodes_expanded)) return INT_MAX;
+    if (f > f_limit) return f;
+    if (p.goal_test(b)) return f;
+    int f_min = INT_MAX;
+    int parent_H = b.H;
+    Board::Action acts[4];
+    int n = p.actions(b, moves.empty() ? Board::NONE : moves.back(), acts);
+    for (int i = 0; i < n; ++i) {
+        int child_state = 0;
+        if (p.pruner && (child_state = p.pruner->next(state, acts[i])) < 0) continue;
+        p.apply<H>(b, acts[i]);
+        moves.push_back(acts[i]);
+        f = DL_frontier<H>(b, moves, p, g + 1, f_limit, child_state, depth - 1, frontier, nodes_expanded);
+        if (f <= f_limit) return f;
+        if (f < f_min) f_min = f;
+        moves.pop_back();
+        p.undo(b, acts[i], parent_H);
+    }
+    return f_min;
+}
+
+// Every f_limit iteration is split at a shallow frontier whose subtrees are
+// searched by the pool's workers. The first worker to reach the goal cancels
+// the rest; any solution within f_limit is optimal, since every smaller limit
+// has already failed.
+template<class H>
+vector<Board> Parallel_ID_A_star(Board &start, Problem &p, int &nodes_expanded, WorkStealingPool &pool) {
+    const size_t SUBTREES_PER_WORKER = 16;
+    const int MAX_FRONTIER_DEPTH = 12;
+    start.H = p.init<H>(start);
+    int f_limit = Heuristic::value(start.H);
+    int depth = 1;
+    while (1) {
+        Board b = start;
+        vector<Board::Action> moves;
+        vector<vector<Board::Action>> frontier;
+        int f_min;
+        while (1) {                     // deepen the frontier until every worker has enough to steal
+            frontier.clear();
+            int walked = 0;
+            f_min = DL_frontier<H>(b, moves, p, 0, f_limit, 0, depth, frontier, walked);
+            nodes_expanded += walked;
+            if (p.budget) p.budget->charge(walked & (SearchBudget::POLL - 1));
+            if (f_min <= f_limit) {
+                if (p.budget) p.budget->lower_bound = moves.size();
+                return p.replay(start, moves);
+            }
+            if (frontier.size() >= SUBTREES_PER_WORKER * pool.size() || depth == MAX_FRONTIER_DEPTH
+                || (p.budget && p.budget->exhausted()))
+                break;
+            ++depth;
+        }
+
+        atomic<bool> found{ false };
+        atomic<int> subtree_f_min{ INT_MAX };
+        atomic<int> subtree_nodes{ 0 };
+        vector<Board::Action> solution;
+        mutex solution_m;
+        CountdownLatch done(frontier.size());
+        for (vector<Board::Action> &prefix : frontier) {
+            pool.submit([&](int) {
+                if (!found.load(memory_order_relaxed) && !(p.budget && p.budget->exhausted())) {
+                    Board sub = start;
+                    int state = 0;
+                    for (Board::Action a : prefix) {
+                        p.apply<H>(sub, a);
+                        if (p.pruner) state = p.pruner->next(state, a);
+                    }
+                    vector<Board::Action> submoves = prefix;
+                    submoves.reserve(128);
+                    int nodes = 0;
+                    int f = DL_A_star<H>(sub, submoves, p, prefix.size(), f_limit, state, nodes, &found);
+                    subtree_nodes += nodes;
+                    if (p.budget) p.budget->charge(nodes & (SearchBudget::POLL - 1));
+                    if (f <= f_limit) {
+                        lock_guard<mutex> lock(solution_m);
+                        if (!found.exchange(true)) solution = move(submoves);
+                    } else {
+                        int cur = subtree_f_min.load();
+                        while (f < cur && !subtree_f_min.compare_exchange_weak(cur, f));
+                    }
+                }
+                done.count_down();
+            });
+        }
+        done.wait();
+        nodes_expanded += subtree_nodes;
+        if (found) {
+            if (p.budget) p.budget->lower_bound = solution.size();
+            return p.replay(start, solution);
+        }
+        if (p.budget && p.budget->exhausted()) {
+            p.budget->lower_bound = f_limit;
+            return vector<Board>();
+        }
+        f_min = min(f_min, subtree_f_min.load());
+        if (f_min == INT_MAX) return vector<Board>();
+        f_limit = f_min;
+    }
+}
+
+/*****************************************
+ * Anytime weighted IDA*
+ *
+ * IDA* on f = g + w h for falling weights
+ * w, ending with plain IDA*. A solution
+ * found with weight w is at most w times
+ * the optimum. Each one found bounds the
+ * later runs, which cut off every node that
+ * cannot lead to a shorter solution, and
+ * every failed iteration raises a lower
+ * bound on the optimum. When the budget
+ * runs out the best solution so far is
+ * returned with that bound.
+ *****************************************/
+// Weights in quarters: 3, 2, 1.5, 1.25, 1
+const int ANYTIME_WEIGHTS[] = { 12, 8, 6, 5, 4 };
+
+// DL_A_star on f = 4 g + w h, with w in quarters, that also cuts off nodes
+// whose unweighted f reaches `bound`, the length of the best solution so far.
+template<class H>
+int DL_weighted(Board &b, vector<Board::Action> &moves, Problem &p, int g, int w, int f_limit, int bound,
+                int &nodes_expanded) {
+    int h = Heuristic::value(b.H);
+    ++nodes_expanded;
+    if (p.budget && p.budget->spent(nodes_expanded)) return INT_MAX;
+    if (g + h >= bound) return INT_MAX;
+    int f = 4 * g + w * h;
+    if (f > f_limit) return f;
+    if (p.goal_test(b)) return f;
+    int f_min = INT_MAX;
+    int parent_H = b.H;
+    Board::Action acts[4];
+    int n = p.actions(b, moves.empty() ? Board::NONE : moves.back(), acts);
+    for (int i = 0; i < n; ++i) {
+        p.apply<H>(b, acts[i]);
+        moves.push_back(acts[i]);
+        f = DL_weighted<H>(b, moves, p, g + 1, w, f_limit, bound, nodes_expanded);
+        if (f <= f_limit) return f;
+        if (f < f_min) f_min = f;
+        moves.pop_back();
+        p.undo(b, acts[i], parent_H);
+    }
+    return f_min;
+}
+
+// Along an optimal path 4 g + w h <= w (g + h) <= w * optimum, so when an
+// iteration with limit f_limit fails, either the optimum is at least the
+// bound or it exceeds f_limit / w.
+template<class H>
+vector<Board> Anytime_ID_A_star(Board &start, Problem &p, int &nodes_expanded) {
+    start.H = p.init<H>(start);
+    int h = Heuristic::value(start.H);
+    int lower = h;                      // no solution is shorter than min(lower, bound)
+    int bound = INT_MAX;                // length of the best solution so far
+    vector<Board::Action> best;
+    for (int w : ANYTIME_WEIGHTS) {
+        Board b = start;
+        vector<Board::Action> moves;
+        moves.reserve(128);
+        int f_limit = w * h;
+        while (lower < bound && !(p.budget && p.budget->exhausted())) {
+            int f_min = DL_weighted<H>(b, moves, p, 0, w, f_limit, bound, nodes_expanded);
+            if (f_min <= f_limit) {
+                best = moves;
+                bound = moves.size();
+                if (w == 4) lower = bound;  // plain IDA* finds an optimal solution first
+                break;
+            }
+            if (p.budget && p.budget->exhausted()) break;
+            if (f_min == INT_MAX) lower = bound;    // nothing shorter than bound is left
+            else lower = max(lower, f_limit / w + 1);
+            f_limit = f_min;
+        }
+        if (lower >= bound || (p.budget && p.budget->exhausted())) break;
+    }
+    if (p.budget) p.budget->lower_bound = min(lower, bound);
+    if (bound == INT_MAX) return vector<Board>();
+    return p.replay(start, best);
+}
+
+/**********************
+ *   RBFS Algorithm   *     // with parent move pruning
+ **********************/
+struct RBFSChild {
+    Board::Action a;
+    int F;
+};
+
+// b is moved in place like in DL_A_star; F is its backed-up f value. The
+// children are kept in order of F in a small array in the frame. Only the
+// front child's F changes between iterations, so it is moved back into
+// place rather than sorting again; equal Fs keep their order.
+template<class H>
+int RBFS(Board &b, vector<Board::Action> &moves, Problem &p, int g, int F, int f_limit, int &nodes_expanded) {
+    ++nodes_expanded;
+    if (p.budget && p.budget->spent(nodes_expanded)) return INT_MAX;
+    STAT(if (p.stats && (int)moves.size() > p.stats->max_depth) p.stats->max_depth = moves.size();)
+    if (p.goal_test(b)) return F;
+    int parent_H = b.H;
+    Board::Action acts[4];
+    int n;
+    TIMED(p.stats, successor_ticks, n = p.actions(b, moves.empty() ? Board::NONE : moves.back(), acts));
+    if (n == 0) return INT_MAX;
+    RBFSChild successors[4];
+    for (int i = 0; i < n; ++i) {
+        TIMED(p.stats, heuristic_ticks, p.apply<H>(b, acts[i]));
+        RBFSChild child = { acts[i], max(g + Heuristic::value(b.H), F) };
+        p.undo(b, acts[i], parent_H);
+        int j = i;
+        for (; j > 0 && child.F < successors[j - 1].F; --j)
+            successors[j] = successors[j - 1];
+        successors[j] = child;
+    }
+    STAT(unsigned searched = 0;)                    // actions whose subtrees have been searched
+    while (1) {
+        RBFSChild &best = successors[0];
+        if (best.F > f_limit) return best.F;
+        int new_f_limit = n > 1 ? min(f_limit, successors[1].F) : f_limit;
+        STAT(if (p.stats && (searched & 1u << best.a)) ++p.stats->reexpansions;
+             searched |= 1u << best.a;)
+        TIMED(p.stats, heuristic_ticks, p.apply<H>(b, best.a));
+        moves.push_back(best.a);
+        best.F = RBFS<H>(b, moves, p, g + 1, best.F, new_f_limit, nodes_expanded);
+        if (best.F <= new_f_limit) return best.F;
+        moves.pop_back();
+        p.undo(b, best.a, parent_H);
+        RBFSChild searched_child = best;
+        int j = 0;
+        for (; j + 1 < n && successors[j + 1].F < searched_child.F; ++j)
+            successors[j] = successors[j + 1];
+        successors[j] = searched_child;
+    }
+}
+
+template<class H>
+vector<Board> RecursiveBestFirst(Board &start, Problem &p, int &nodes_expanded) {
+    start.H = p.init<H>(start);
+    Board b = start;
+    vector<Board::Action> moves;
+    moves.reserve(128);
+    RBFS<H>(b, moves, p, 1, Heuristic::value(start.H), INT_MAX, nodes_expanded);
+    if (p.budget) {
+        // A search cut short may unwind as if it had succeeded, so check b
+        if (!p.goal_test(b)) {
+            p.budget->lower_bound = Heuristic::value(start.H);
+            return vector<Board>();
+        }
+        p.budget->lower_bound = moves.size();
+    }
+    return p.replay(start, moves);
+}
+
+
+/*****************************************
+ * Bidirectional MM search
+ *
+ * MM (Holte et al.) searches forward from
+ * the start and backward from the goal. It
+ * always expands on the side whose open
+ * list has the smallest priority max(f, 2g),
+ * and stops once the best solution found is
+ * no longer than every lower bound on a
+ * shorter one.
+ *
+ * The heuristics only estimate the distance
+ * to the goal, so the backward side uses
+ * the Manhattan distance to the start.
+ *****************************************/
+// Manhattan distance to a fixed target board, kept in Board::H
+class ManhattanTo {
+    uint8_t d[Board::CELLS][Board::CELLS];  // d[v][c]: moves tile v needs from cell c to its cell in the target
+public:
+    explicit ManhattanTo(const Board &target) {
+        for (int t = 0; t < Board::CELLS; ++t) {
+            int v = target.get(t);
+            for (int c = 0; c < Board::CELLS; ++c)
+                d[v][c] = v ? abs(c / Board::COLS - t / Board::COLS) + abs(c % Board::COLS - t % Board::COLS) : 0;
+        }
+    }
+
+    int init(const Board &b) const {
+        int h = 0;
+        for (int c = 0; c < Board::CELLS; ++c)
+            h += d[b.get(c)][c];
+        return h;
+    }
+
+    void apply(Board &b, Board::Action a) const {
+        int to = b.blank;
+        int from = b.target(a);
+        int tile = b.get(from);
+        b.slide(from);
+        b.H += d[tile][to] - d[tile][from];
+    }
+};
+
+// Open addressed map from boards to search nodes. References into it are
+// invalidated by insert().
+class StateMap {
+public:
+    struct Node {
+        Tiles tiles;        // 0 (never a valid board) marks an empty slot
+        int H;
+        uint8_t g;
+        uint8_t blank;
+        uint8_t last;       // action that reached the node at cost g
+        bool open;
+    };
+
+    StateMap() : slots(1024), mask(1023) {}
+
+    Node *find(Tiles tiles) {
+        for (size_t i = slot(tiles); ; i = (i + 1) & mask) {
+            if (slots[i].tiles == tiles) return &slots[i];
+            if (!slots[i].tiles) return nullptr;
+        }
+    }
+
+    Node &insert(Tiles tiles) {
+        if (2 * (count + 1) > slots.size()) grow();
+        size_t i = slot(tiles);
+        while (slots[i].tiles)
+            i = (i + 1) & mask;
+        slots[i].tiles = tiles;
+        ++count;
+        return slots[i];
+    }
+
+    size_t size() const { return count; }
+
+private:
+    vector<Node> slots;
+    size_t mask;
+    size_t count = 0;
+
+    size_t slot(Tiles tiles) const {
+        return ((fold_tiles(tiles) * 0x9E3779B97F4A7C15ULL) >> 20) & mask;
+    }
+
+    void grow() {
+        vector<Node> old(2 * slots.size());
+        old.swap(slots);
+        mask = slots.size() - 1;
+        count = 0;
+        for (Node &n : old)
+            if (n.tiles) insert(n.tiles) = n;
+    }
+};
+
+// One direction of MM: every node reached so far, and the open ones bucketed
+// by priority. Counts by priority, f and g give the minima the stopping rule
+// needs; bucket entries whose node has since been closed or reached more
+// cheaply are skipped when popped.
+class MMSide {
+    static const int LIMIT = 512;   // g and h are below 256
+
+    vector<vector<pair<Tiles, int>>> open;      // (tiles, g) by priority
+    int open_pr[LIMIT] = {}, open_f[LIMIT] = {}, open_g[LIMIT] = {};
+    int pr_lo = 0, f_lo = 0, g_lo = 0;          // lower ends of the nonzero counts
+    int open_count = 0;
+
+    static int priority(int g, int h) { return max(g + h, 2 * g); }
+
+    static int lowest(const int *counts, int &lo) {
+        while (!counts[lo]) ++lo;
+        return lo;
+    }
+
+    void count(int g, int h, int delta) {
+        open_pr[priority(g, h)] += delta;
+        open_f[g + h] += delta;
+        open_g[g] += delta;
+        open_count += delta;
+        if (delta > 0) {
+            pr_lo = min(pr_lo, priority(g, h));
+            f_lo = min(f_lo, g + h);
+            g_lo = min(g_lo, g);
+        }
+    }
+
+public:
+    StateMap nodes;
+
+    MMSide() : open(LIMIT) {}
+
+    bool empty() const { return open_count == 0; }
+    int pr_min() { return lowest(open_pr, pr_lo); }
+    int f_min() { return lowest(open_f, f_lo); }
+    int g_min() { return lowest(open_g, g_lo); }
+
+    // Record b at cost g unless it is known at cost g or less
+    bool reach(const Board &b, int g, Board::Action last) {
+        StateMap::Node *n = nodes.find(b.tiles);
+        if (n) {
+            if (n->g <= g) return false;
+            if (n->open) count(n->g, Heuristic::value(n->H), -1);
+        } else {
+            n = &nodes.insert(b.tiles);
+        }
+        *n = { b.tiles, b.H, (uint8_t)g, (uint8_t)b.blank, (uint8_t)last, true };
+        count(g, Heuristic::value(b.H), 1);
+        open[priority(g, Heuristic::value(b.H))].push_back({ b.tiles, g });
+        return true;
+    }
+
+    // Close an open node of the smallest priority
+    void pop(Board &b, int &g, Board::Action &last) {
+        vector<pair<Tiles, int>> &bucket = open[pr_min()];
+        while (1) {
+            pair<Tiles, int> e = bucket.back();
+            bucket.pop_back();
+            StateMap::Node *n = nodes.find(e.first);
+            if (!n->open || n->g != e.second) continue;
+            n->open = false;
+            count(n->g, Heuristic::value(n->H), -1);
+            b = Board(n->tiles, n->blank);
+            b.H = n->H;
+            g = n->g;
+            last = Board::Action(n->last);
+            return;
+        }
+    }
+
+    // Actions leading from this side's root to `tiles`
+    vector<Board::Action> moves_to(Tiles tiles) {
+        vector<Board::Action> moves;
+        Board b;
+        for (StateMap::Node *n = nodes.find(tiles); n->g > 0; n = nodes.find(b.tiles)) {
+            moves.push_back(Board::Action(n->last));
+            b = Board(n->tiles, n->blank);
+            b.slide(b.target(Board::inverse(Board::Action(n->last))));
+        }
+        reverse(moves.begin(), moves.end());
+        return moves;
+    }
+};
+
+template<class H>
+vector<Board> MM(Board &start, Problem &p, int &nodes_expanded) {
+    start.H = p.init<H>(start);
+    ManhattanTo to_start(start);
+    Board goal;
+    goal.H = to_start.init(goal);
+    MMSide fwd, bwd;
+    fwd.reach(start, 0, Board::NONE);
+    bwd.reach(goal, 0, Board::NONE);
+    int U = p.goal_test(start) ? 0 : INT_MAX;   // best solution so far
+    Tiles meet = start.tiles;
+    int lower = 0;                              // no solution is shorter than min(lower, U)
+    while (!fwd.empty() && !bwd.empty()) {
+        int C = min(fwd.pr_min(), bwd.pr_min());
+        lower = max({ C, fwd.f_min(), bwd.f_min(), fwd.g_min() + bwd.g_min() + 1 });
+        if (U <= lower) break;
+        if (p.budget && p.budget->exhausted()) break;
+        bool forward = fwd.pr_min() <= bwd.pr_min();
+        MMSide &side = forward ? fwd : bwd;
+        MMSide &other = forward ? bwd : fwd;
+        Board b;
+        int g;
+        Board::Action last;
+        side.pop(b, g, last);
+        ++nodes_expanded;
+        if (p.budget) p.budget->spent(nodes_expanded);
+        Board::Action acts[4];
+        int n = p.actions(b, last, acts);
+        for (int i = 0; i < n; ++i) {
+            Board c = b;
+            if (forward) p.apply<H>(c, acts[i]);
+            else to_start.apply(c, acts[i]);
+            if (!side.reach(c, g + 1, acts[i])) continue;
+            StateMap::Node *o = other.nodes.find(c.tiles);
+            if (o && g + 1 + o->g < U) {
+                U = g + 1 + o->g;
+                meet = c.tiles;
+            }
+        }
+    }
+    if (p.budget) p.budget->lower_bound = min(lower, U);
+    if (U == INT_MAX) return vector<Board>();
+
+    // start -> meet, then back along the backward side's moves to the goal
+    vector<Board::Action> moves = fwd.moves_to(meet);
+    vector<Board::Action> back = bwd.moves_to(meet);
+    for (auto a = back.rbegin(); a != back.rend(); ++a)
+        moves.push_back(Board::inverse(*a));
+    return p.replay(start, moves);
+}
+
+
+/*****************************************
+ * Search specialization
+ *
+ * Every search is instantiated once per
+ * heuristic type. solvers_for() picks the
+ * instantiations for a heuristic's dynamic
+ * type once per solve, so no virtual call
+ * is left in the inner loops.
+ *****************************************/
+typedef vector<Board> (*Solver)(Board &, Problem &, int &);
+
+struct Solvers {
+    Solver rbfs;
+    Solver ida_star;
+    Solver mm;
+    Solver anytime;
+    vector<Board> (*parallel_ida_star)(Board &, Problem &, int &, WorkStealingPool &);
+};
+
+template<class H>
+Solvers solvers() {
+    return { RecursiveBestFirst<H>, ID_A_star<H>, MM<H>, Anytime_ID_A_star<H>, Parallel_ID_A_star<H> };
+}
+
+Solvers solvers_for(Heuristic &h) {
+    if (typeid(h) == typeid(ManhattanDistance)) return solvers<ManhattanDistance>();
+    if (typeid(h) == typeid(LinearConflictMD))  return solvers<LinearConflictMD>();
+    if (typeid(h) == typeid(InversionDistance)) return solvers<InversionDistance>();
+    if (typeid(h) == typeid(WalkingDistance))   return solvers<WalkingDistance>();
+    if (typeid(h) == typeid(PatternDatabase))   return solvers<PatternDatabase>();
+    cerr << "No searches instantiated for " << h.get_name() << endl;
+    exit(1);
+}
+
+
+/*****************************************
+ * Instance corpus
+ *
+ * Boards generated in bulk from a seed and
+ * stored one tile word apiece after
+ * a fixed header, so solvers can map the
+ * file and split it into shards. Each block
+ * of BLOCK boards has its own generator,
+ * seeded from (seed, block number), so a
+ * seed always gives the same file whatever
+ * the number of threads. Files are in
+ * native byte order.
+ *****************************************/
+// Moves of the corpus random walks. A state is 4 * cell + the last action,
+// and next[state] lists the states reachable without undoing that action,
+// each repeated to fill six slots. One, two or three choices all divide six,
+// so a draw from [0, 6) picks among them without bias.
+struct WalkMoves {
+    uint8_t next[Board::CELLS * 4][6];
+    constexpr WalkMoves() : next() {
+        const int dr[] = { -1, 1, 0, 0 }, dc[] = { 0, 0, -1, 1 };
+        for (int c = 0; c < Board::CELLS; ++c) {
+            for (int last = 0; last < 4; ++last) {
+                int to[4] = {}, n = 0;
+                for (int a = 0; a < 4; ++a) {
+                    int r = c / Board::COLS + dr[a], k = c % Board::COLS + dc[a];
+                    if (a != (last ^ 1) && r >= 0 && r < Board::ROWS && k >= 0 && k < Board::COLS)
+                        to[n++] = 4 * (r * Board::COLS + k) + a;
+                }
+                for (int slot = 0; slot < 6; ++slot)
+                    next[4 * c + last][slot] = to[slot * n / 6];
+            }
+        }
+    }
+};
+
+constexpr WalkMoves WALK_MOVES{};
+
+class InstanceCorpus {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+    static constexpr uint64_t BLOCK = 1 << 16;
+
+    struct FileHeader {
+        char magic[4];          // "PA2I"
+        uint32_t version;
+        uint32_t rows;
+        uint32_t cols;
+        uint32_t walk;          // moves per random walk, 0 for uniform random boards
+        uint32_t reserved;
+        uint64_t seed;
+        uint64_t count;         // tile words following the header
+    };
+
+    InstanceCorpus() {}
+    InstanceCorpus(const InstanceCorpus &) = delete;
+    InstanceCorpus& operator=(const InstanceCorpus &) = delete;
+
+    ~InstanceCorpus() {
+        if (map) munmap(map, map_len);
+    }
+
+    // Tiles of a board drawn uniformly from the solvable ones. Every move
+    // swaps the blank with a neighbour, so on a solvable board the parity of
+    // the permutation equals that of the blank's distance from its goal cell.
+    // A shuffle that misses gets two tiles away from the blank swapped, which
+    // pairs each unsolvable board with a solvable one with the same blank.
+    static Tiles random_tiles(SplitMix64 &rng) {
+        uint8_t cell[Board::CELLS];
+        for (int c = 0; c < Board::CELLS; ++c)
+            cell[c] = (Board::GOAL >> (TILE_BITS * c)) & TILE_MASK;
+        uint64_t bits = 0;
+        bool odd = false;
+        for (int i = Board::CELLS - 1; i > 0; --i) {
+            if (i % 8 == 7 || i == Board::CELLS - 1) bits = rng();    // 8 draws use at most 36 bits
+            int j = SplitMix64::take(bits, i + 1);
+            swap(cell[i], cell[j]);
+            odd ^= i != j;
+        }
+        Tiles t = 0;
+        for (int c = 0; c < Board::CELLS; ++c)
+            t |= (Tiles)cell[c] << (TILE_BITS * c);
+        int blank = find_blank(t);
+        int distance = (Board::ROWS - 1 - blank / Board::COLS) + (Board::COLS - 1 - blank % Board::COLS);
+        if (odd != (distance % 2 == 1)) {
+            int a = blank < 2 ? 2 : 0;
+            Tiles x = ((t >> (TILE_BITS * a)) ^ (t >> (TILE_BITS * (a + 1)))) & TILE_MASK;
+            t ^= (x << (TILE_BITS * a)) | (x << (TILE_BITS * (a + 1)));
+        }
+        return t;
+    }
+
+    // Tiles after a random walk of m moves from the goal that never undoes
+    // its last move. The walk starts as if the blank had just moved up,
+    // which rules out nothing from the bottom right corner.
+    static Tiles walk_tiles(SplitMix64 &rng, int m) {
+        Tiles t = Board::GOAL;
+        uint64_t bits = 0;
+        int state = 4 * (Board::CELLS - 1) + Board::UP;
+        for (int i = 0; i < m; ++i) {
+            if (i % 12 == 0) bits = rng();      // 12 draws use at most 32 bits
+            int from = state >> 2;
+            state = WALK_MOVES.next[state][SplitMix64::take(bits, 6)];
+            int c = state >> 2;
+            Tiles tile = (t >> (TILE_BITS * c)) & TILE_MASK;
+            t ^= (tile << (TILE_BITS * c)) | (tile << (TILE_BITS * from));
+        }
+        return t;
+    }
+
+    // Write `count` boards to path: random walks of `walk` moves, or uniform
+    // random boards when walk is 0. Each block is generated into a buffer of
+    // its own and written at its offset.
+    static bool generate(const string &path, uint64_t count, int walk, uint64_t seed, int threads) {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            cerr << "Cannot write " << path << endl;
+            return false;
+        }
+        FileHeader hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, "PA2I", 4);
+        hdr.version = FORMAT_VERSION;
+        hdr.rows = Board::ROWS;
+        hdr.cols = Board::COLS;
+        hdr.walk = walk;
+        hdr.seed = seed;
+        hdr.count = count;
+        atomic<bool> ok{ pwrite(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr) };
+
+        chrono::time_point<chrono::high_resolution_clock> t0, t1;
+        t0 = chrono::high_resolution_clock::now();
+        {
+            WorkStealingPool pool(threads);
+            for (uint64_t first = 0; first < count; first += BLOCK) {
+                pool.submit([=, &ok](int) {
+                    SplitMix64 rng{ SplitMix64::mix(seed + SplitMix64::mix(first / BLOCK)) };
+                    uint64_t n = min(BLOCK, count - first);
+                    vector<Tiles> boards(n);
+                    for (uint64_t i = 0; i < n; ++i)
+                        boards[i] = walk ? walk_tiles(rng, walk) : random_tiles(rng);
+                    size_t bytes = n * sizeof(Tiles);
+                    if (pwrite(fd, boards.data(), bytes, sizeof(FileHeader) + first * sizeof(Tiles)) != (ssize_t)bytes)
+                        ok = false;
+                });
+            }
+            pool.wait();
+        }
+        t1 = chrono::high_resolution_clock::now();
+        if (close(fd) < 0 || !ok) {
+            cerr << "Cannot write " << path << endl;
+            return false;
+        }
+        double seconds = chrono::duration<double>(t1 - t0).count();
+        cout << "Wrote " << count << (walk ? " random walks of " + to_string(walk) + " moves" : " uniform random boards")
+             << " to " << path << " in " << seconds << " s (" << count / seconds / 1e6 << " M/s)" << endl;
+        return true;
+    }
+
+    static bool is_corpus(const string &path) {
+        char magic[4] = {};
+        ifstream in(path, ios::binary);
+        return in.read(magic, 4) && memcmp(magic, "PA2I", 4) == 0;
+    }
+
+    bool load(const string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << "Cannot open instance corpus " << path << endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+            cerr << path << ": not an instance corpus" << endl;
+            close(fd);
+            return false;
+        }
+        void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) {
+            cerr << "Cannot map instance corpus " << path << endl;
+            return false;
+        }
+        if (map) munmap(map, map_len);
+        map = m;
+        map_len = st.st_size;
+        hdr = nullptr;
+
+        const FileHeader &h = *(const FileHeader *)map;
+        if (memcmp(h.magic, "PA2I", 4) != 0 || h.version != FORMAT_VERSION) {
+            cerr << path << ": unsupported instance corpus format" << endl;
+            return false;
+        }
+        if (h.rows != Board::ROWS || h.cols != Board::COLS) {
+            cerr << path << ": instance corpus does not match the board" << endl;
+            return false;
+        }
+        if (h.count > (map_len - sizeof(FileHeader)) / sizeof(Tiles)) {
+            cerr << path << ": truncated instance corpus" << endl;
+            return false;
+        }
+        hdr = &h;
+        boards = (const char *)(&h + 1);
+        return true;
+    }
+
+    uint64_t size() const { return hdr ? hdr->count : 0; }
+
+    // First board of shard k of n; shard k runs up to shard_begin(k + 1, n)
+    uint64_t shard_begin(int k, int n) const {
+        return size() / n * k + min<uint64_t>(k, size() % n);
+    }
+
+    // Cell of the zero tile, for a word holding each tile once
+    static int find_blank(Tiles t) {
+        if (TILE_BITS != 4) {
+            int c = 0;
+            while ((t >> (TILE_BITS * c)) & TILE_MASK) ++c;
+            return c;
+        }
+        const uint64_t LOW = 0x1111111111111111ULL >> (4 * (TILE_SLOTS - Board::CELLS));
+        uint64_t n = (uint64_t)t;
+        n |= n >> 1;
+        n |= n >> 2;
+        return __builtin_ctzll(~n & LOW) / 4;
+    }
+
+    // Board i, or false if the word there is not a solvable board
+    bool get(uint64_t i, Board &b) const {
+        Tiles t;
+        memcpy(&t, boards + i * sizeof(Tiles), sizeof(t));     // 128-bit words are not 16-byte aligned
+        uint32_t seen = 0;
+        int blank = 0;
+        for (int c = 0; c < Board::CELLS; ++c) {
+            int v = (int)(t >> (TILE_BITS * c)) & TILE_MASK;
+            if (v >= Board::CELLS || (seen & (1u << v))) return false;
+            seen |= 1u << v;
+            if (v == 0) blank = c;
+        }
+        if (Board::CELLS < TILE_SLOTS && (t >> (TILE_BITS * (Board::CELLS % TILE_SLOTS)))) return false;
+        b = Board(t, blank);
+        return b.solvable();
+    }
+
+private:
+    void *map = nullptr;
+    size_t map_len = 0;
+    const FileHeader *hdr = nullptr;
+    const char *boards = nullptr;
+};
+
+
+void csv_write_headers(std::ostream& f) {
+    f << "Board_ID, Scramble_Number, Algorithm, Heuristic, Moves, Nodes_Expanded, Computation_Time(us)" << '\n';
+}
+
+void csv_write_row(std::ostream& f, int board_id, int scramble_num, const string &algo, const string &heuristic, size_t moves, int nodes_exp, long microseconds) {
+    long micros = std::max(1L, microseconds);
+    f << board_id << "," << scramble_num << "," << algo << "," << heuristic << "," << moves << "," << nodes_exp << "," << micros << '\n';
+}
+
+
+/*****************************************
+ * Results sink
+ *
+ * Workers hand each finished trial to the
+ * sink and go straight back to solving. A
+ * background thread writes the rows out in
+ * Board_ID order, a batch at a time, so a
+ * slow drive never stalls a worker or
+ * shows up in a solve time.
+ *
+ * Besides the CSV the sink can write a
+ * binary columnar file:
+ *   "PA2R", uint32 version (1)
+ *   uint8 count, then per algorithm name: uint8 length, bytes
+ *   uint8 count, then per heuristic name: uint8 length, bytes
+ *   blocks of: uint32 rows, then the columns
+ *     int32 board_id, uint8 scramble_num, uint8 algorithm,
+ *     uint8 heuristic, uint16 moves, int32 nodes_expanded,
+ *     int64 microseconds
+ *   uint32 0
+ * in native byte order, with algorithm and
+ * heuristic as indexes into the name lists.
+ *****************************************/
+struct Result {
+    int board_id;
+    int scramble_num;
+    uint8_t algo;               // index into the sink's algorithm names
+    uint8_t heuristic;          // index into its heuristic names
+    size_t moves;
+    int nodes_exp;
+    long microseconds;
+    STAT(SearchStats stats;)
+};
+
+class ResultSink {
+    static const size_t BATCH = 4096;
+    const vector<string> algorithms;
+    const vector<string> heuristics;
+    ofstream csv;
+    ofstream bin;
+    ofstream trace;
+    vector<Result> rows;        // row i is Board_ID i + 1
+    vector<char> ready;
+    size_t next = 0;            // rows before this one are all ready
+    size_t notified = 0;        // value of next when the writer was last woken
+    bool binary;
+    bool tracing;
+    mutex m;
+    condition_variable cv;
+    thread writer;
+
+    template<class T, class F>
+    void put_column(const Result *r, size_t n, F Result::*field) {
+        vector<T> column(n);
+        for (size_t i = 0; i < n; ++i) column[i] = (T)(r[i].*field);
+        bin.write((const char *)column.data(), n * sizeof(T));
+    }
+
+    void put_names(const vector<string> &names) {
+        bin.put((char)names.size());
+        for (const string &name : names) {
+            bin.put((char)name.size());
+            bin.write(name.data(), name.size());
+        }
+    }
+
+    void write_batch(const Result *r, size_t n) {
+        for (size_t i = 0; i < n; ++i)
+            csv_write_row(csv, r[i].board_id, r[i].scramble_num, algorithms[r[i].algo], heuristics[r[i].heuristic],
+                          r[i].moves, r[i].nodes_exp, r[i].microseconds);
+        STAT(if (tracing) for (size_t i = 0; i < n; ++i) write_trace(r[i]);)
+        if (!binary) return;
+        uint32_t count = n;
+        bin.write((const char *)&count, sizeof(count));
+        put_column<int32_t>(r, n, &Result::board_id);
+        put_column<uint8_t>(r, n, &Result::scramble_num);
+        put_column<uint8_t>(r, n, &Result::algo);
+        put_column<uint8_t>(r, n, &Result::heuristic);
+        put_column<uint16_t>(r, n, &Result::moves);
+        put_column<int32_t>(r, n, &Result::nodes_exp);
+        put_column<int64_t>(r, n, &Result::microseconds);
+    }
+
+    STAT(void write_trace(const Result &r) {
+        const SearchStats &s = r.stats;
+        trace << r.board_id << ",";
+        for (size_t i = 0; i < s.iteration_nodes.size(); ++i)
+            trace << (i ? ";" : "") << s.iteration_nodes[i];
+        trace << "," << s.reexpansions << "," << s.max_depth << "," << s.heuristic_ticks << "," << s.hash_ticks
+              << "," << s.successor_ticks << "," << s.cycles << "," << s.cache_misses << "," << s.branch_misses
+              << '\n';
+    })
+
+    void run() {
+        size_t written = 0;
+        while (written < rows.size()) {
+            size_t end;
+            {
+                unique_lock<mutex> lock(m);
+                cv.wait(lock, [&] { return next - written >= BATCH || next == rows.size(); });
+                end = next;
+            }
+            write_batch(&rows[written], end - written);     // these rows are no longer touched by workers
+            written = end;
+        }
+        csv.flush();
+        if (tracing) trace.flush();
+        if (binary) {
+            uint32_t last = 0;
+            bin.write((const char *)&last, sizeof(last));
+            bin.flush();
+        }
+    }
+
+public:
+    // Opens the output files; check ok() before handing out rows.
+    // The trace is only written in PA2_STATS builds.
+    ResultSink(size_t n, const string &csv_path, const string &bin_path, const string &trace_path,
+               vector<string> algorithms, vector<string> heuristics)
+        : algorithms(move(algorithms)), heuristics(move(heuristics)), csv(csv_path), rows(n), ready(n, 0),
+          binary(!bin_path.empty()), tracing(!trace_path.empty()) {
+        if (!csv) cerr << "Cannot open " << csv_path << endl;
+        if (binary) {
+            bin.open(bin_path, ios::binary);
+            if (!bin) cerr << "Cannot open " << bin_path << endl;
+        }
+        if (tracing) {
+            trace.open(trace_path);
+            if (!trace) cerr << "Cannot open " << trace_path << endl;
+        }
+    }
+
+    ~ResultSink() { close(); }
+
+    bool ok() const { return csv && (!binary || bin) && (!tracing || trace); }
+
+    void start() {
+        csv_write_headers(csv);
+        if (tracing)
+            trace << "Board_ID, Iteration_Nodes, Reexpansions, Max_Depth, Heuristic_Ticks, Hash_Ticks, "
+                     "Successor_Ticks, Cycles, Cache_Misses, Branch_Misses" << '\n';
+        if (binary) {
+            uint32_t version = 1;
+            bin.write("PA2R", 4);
+            bin.write((const char *)&version, sizeof(version));
+            put_names(algorithms);
+            put_names(heuristics);
+        }
+        writer = thread(&ResultSink::run, this);
+    }
+
+    // Called by the workers; never waits on the files.
+    void put(Result r) {
+        lock_guard<mutex> lock(m);
+        size_t i = r.board_id - 1;
+        rows[i] = move(r);
+        ready[i] = 1;
+        if (i != next) return;
+        while (next < rows.size() && ready[next]) ++next;
+        if (next - notified >= BATCH || next == rows.size()) {
+            notified = next;
+            cv.notify_one();
+        }
+    }
+
+    // Waits for every row to be written. All rows must have been put.
+    void close() {
+        if (writer.joinable()) writer.join();
+    }
+};
+
+// A single solve of the experiment, filled in by whichever worker runs it
+struct Trial {
+    int board_id;
+    int board_seed;             // Board_ID whose board this trial solves
+    int scramble_num;
+    string algo;
+    Heuristic *heuristic;
+    uint8_t algo_code;          // indexes of algo and heuristic in the results sink's names
+    uint8_t heuristic_code;
+    Solver solve;
+    bool transpositions;        // give the solver the worker's transposition table
+    bool pruning;               // give the solver the duplicate move pruner
+    size_t moves;
+    int nodes_exp;
+    long microseconds;
+};
+
+void usage() {
+    cerr << "usage: pa2 [--pdb FILE] [--trials N] [--threads N] [--seed N] [--tt MB] [--fsm DEPTH] [--binary FILE] [--trace FILE]" << endl
+         << "       pa2 --solve \"TILES\" [--algorithm ida|rbfs|mm|anytime|portfolio] [--heuristic md|lc|id|wd|pdb] [--pdb FILE] [--threads N]" << endl
+         << "                 [--tt MB] [--max-nodes N] [--max-ms MS] [--fsm DEPTH]" << endl
+         << "       pa2 --batch FILE|- [--shard K/N] [--algorithm ida|rbfs|mm|anytime] [--heuristic md|lc|id|wd|pdb] [--pdb FILE]" << endl
+         << "                 [--threads N] [--tt MB] [--max-nodes N] [--max-ms MS] [--fsm DEPTH]" << endl
+         << "       pa2 --gen-instances FILE [--count N] [--walk MOVES] [--seed N] [--threads N]" << endl
+         << "       pa2 --bench [--bench-set FILE] [--korf FILE] [--pdb FILE] [--seed N]" << endl
+         << "       pa2 --self-test [--seed N]" << endl
+         << "       pa2 --gen-pdb [FILE]" << endl;
+}
+
+// Settings shared by --solve and --batch
+struct SolveOptions {
+    int threads = 0;
+    size_t tt_mb = 0;                   // transposition table per worker; IDA* only
+    SearchLimits limits;
+    const MovePruner *pruner = nullptr; // IDA* only
+};
+
+// Parse a board given on the command line, reporting why it is not usable
+bool read_start(const string &tiles, Board &start) {
+    istringstream in(tiles);
+    if (!start.read(in)) {
+        cerr << "Expected " << Board::CELLS << " distinct tiles 0-" << Board::CELLS - 1 << ", got \"" << tiles << "\"" << endl;
+        return false;
+    }
+    if (!start.solvable()) {
+        cerr << "Board is not solvable" << endl;
+        return false;
+    }
+    return true;
+}
+
+// Solve one board and print the result. IDA* runs in parallel on the pool,
+// unless it has a transposition table, which its workers cannot share.
+int solve_one(const string &tiles, Heuristic &h, Solver Solvers::*algo, const SolveOptions &opts) {
+    Board start;
+    if (!read_start(tiles, start)) return 1;
+    WorkStealingPool pool(opts.tt_mb ? 1 : opts.threads);
+    Problem p(h);
+    SearchBudget budget(opts.limits);
+    if (opts.limits.any()) p.budget = &budget;
+    p.pruner = opts.pruner;
+    unique_ptr<TranspositionTable> tt;
+    if (opts.tt_mb) {
+        tt.reset(new TranspositionTable(opts.tt_mb));
+        p.tt = tt.get();
+    }
+    int nodes_expanded = 0;
+    chrono::time_point<chrono::high_resolution_clock> t0, t1;
+    t0 = chrono::high_resolution_clock::now();
+    vector<Board> solution = algo == &Solvers::ida_star && !p.tt
+                           ? solvers_for(h).parallel_ida_star(start, p, nodes_expanded, pool)
+                           : (solvers_for(h).*algo)(start, p, nodes_expanded);
+    t1 = chrono::high_resolution_clock::now();
+    chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(t1 - t0);
+    cout << "Heuristic: " << h.get_name() << ", threads: " << pool.size() << endl;
+    if (solution.empty()) cout << "No solution within the budget";
+    else cout << "Moves: " << solution.size() - 1;
+    if (opts.limits.any()) cout << ", Lower_Bound: " << budget.lower_bound;
+    cout << ", Nodes_Expanded: " << nodes_expanded << ", Computation_Time(us): " << duration.count() << endl;
+    return 0;
+}
+
+// One search in a portfolio: an algorithm with a heuristic
+struct PortfolioMember {
+    const char *algorithm;
+    Solver Solvers::*solve;
+    Heuristic *h;
+};
+
+// The searches that --algorithm portfolio races: IDA* and RBFS with every
+// heuristic. More variants only need an entry here.
+vector<PortfolioMember> portfolio_members(const vector<Heuristic*> &heuristics) {
+    vector<PortfolioMember> members;
+    for (Heuristic *h : heuristics) {
+        members.push_back({ "IDA*", &Solvers::ida_star, h });
+        members.push_back({ "RBFS", &Solvers::rbfs, h });
+    }
+    return members;
+}
+
+// Solve one board with every member at once, each on a thread of its own,
+// and print the first solution proven optimal. The winner cancels the others'
+// budgets, so they stop at their next poll. A solution counts only once its
+// search's lower bound has reached its length, so a member that returns the
+// best it found when cut short never wins. The limits apply to each member on
+// its own; without a winner, the best lower bound any member proved is
+// reported. --fsm applies to the IDA* members.
+int solve_portfolio(const string &tiles, const vector<PortfolioMember> &members, const SolveOptions &opts) {
+    Board start;
+    if (!read_start(tiles, start)) return 1;
+    struct Run {
+        unique_ptr<SearchBudget> budget;
+        vector<Board> solution;
+        int nodes_expanded = 0;
+    };
+    vector<Run> runs(members.size());
+    for (Run &r : runs)
+        r.budget.reset(new SearchBudget(opts.limits));
+    int winner = -1;
+    mutex winner_m;
+    chrono::time_point<chrono::high_resolution_clock> t0, t1;
+    t0 = chrono::high_resolution_clock::now();
+    {
+        WorkStealingPool pool(members.size());
+        for (size_t i = 0; i < members.size(); ++i) {
+            pool.submit([&, i](int) {
+                const PortfolioMember &m = members[i];
+                Run &r = runs[i];
+                Problem p(*m.h);
+                p.budget = r.budget.get();
+                if (m.solve == &Solvers::ida_star) p.pruner = opts.pruner;
+                Board b = start;
+                r.solution = (solvers_for(*m.h).*m.solve)(b, p, r.nodes_expanded);
+                if (r.solution.empty() || r.budget->lower_bound < (int)r.solution.size() - 1) return;
+                lock_guard<mutex> lock(winner_m);
+                if (winner >= 0) return;
+                winner = i;
+                t1 = chrono::high_resolution_clock::now();
+                for (Run &other : runs)
+                    if (&other != &r) other.budget->cancel();
+            });
+        }
+        pool.wait();
+    }
+    if (winner < 0) t1 = chrono::high_resolution_clock::now();
+    chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(t1 - t0);
+    long total_nodes = 0;
+    int lower_bound = 0;
+    for (Run &r : runs) {
+        total_nodes += r.nodes_expanded;
+        lower_bound = max(lower_bound, r.budget->lower_bound);
+    }
+    cout << "Portfolio of " << members.size() << " searches";
+    if (winner < 0) {
+        cout << endl << "No solution within the budget, Lower_Bound: " << lower_bound;
+    } else {
+        const PortfolioMember &m = members[winner];
+        const Run &r = runs[winner];
+        cout << ", won by " << m.algorithm << " with " << m.h->get_name() << endl
+             << "Moves: " << r.solution.size() - 1 << ", Nodes_Expanded: " << r.nodes_expanded;
+    }
+    cout << ", Total_Nodes_Expanded: " << total_nodes << ", Computation_Time(us): " << duration.count() << endl;
+    return 0;
+}
+
+// A board for solve_jobs() and the number its result is reported under
+struct BatchJob {
+    long line;
+    Board start;
+};
+
+// Solve the boards that feed(jobs) pushes, on a pool of workers. Boards reach
+// the workers through a bounded queue, so the input is never held in memory,
+// and every result is written as soon as it is solved. Returns feed's status.
+// With limits, each board gets a budget of its own; boards left unsolved have
+// an empty Moves column, and a Lower_Bound column is added.
+template<class Feed>
+int solve_jobs(const char *label, Feed feed, Heuristic &h, Solver Solvers::*algo, const SolveOptions &opts) {
+    const SearchLimits &limits = opts.limits;
+    WorkStealingPool pool(opts.threads);
+    BoundedQueue<BatchJob> jobs(4 * pool.size());
+    Solver solve = solvers_for(h).*algo;
+    mutex io;
+    cout << label << ", Moves, Nodes_Expanded, Computation_Time(us), Solution"
+         << (limits.any() ? ", Lower_Bound" : "") << endl;
+    for (int w = 0; w < pool.size(); ++w) {
+        pool.submit([&](int) {
+            Problem p(h);
+            p.pruner = opts.pruner;
+            unique_ptr<TranspositionTable> tt;
+            if (opts.tt_mb) {
+                tt.reset(new TranspositionTable(opts.tt_mb));
+                p.tt = tt.get();
+            }
+            BatchJob job;
+            while (jobs.pop(job)) {
+                SearchBudget budget(limits);
+                if (limits.any()) p.budget = &budget;
+                int nodes_expanded = 0;
+                chrono::time_point<chrono::high_resolution_clock> t0, t1;
+                t0 = chrono::high_resolution_clock::now();
+                vector<Board> solution = solve(job.start, p, nodes_expanded);
+                t1 = chrono::high_resolution_clock::now();
+                p.budget = nullptr;
+                long micros = max(1L, (long)chrono::duration_cast<chrono::microseconds>(t1 - t0).count());
+                string moves = p.moves_string(solution);
+                lock_guard<mutex> lock(io);
+                cout << job.line << ",";
+                if (!solution.empty()) cout << solution.size() - 1;
+                cout << "," << nodes_expanded << "," << micros << "," << moves;
+                if (limits.any()) cout << "," << budget.lower_bound;
+                cout << '\n';
+            }
+        });
+    }
+    int status = feed(jobs);
+    jobs.close();
+    pool.wait();
+    return status;
+}
+
+// Solve the boards in `in`, one per line
+int solve_batch(istream &in, Heuristic &h, Solver Solvers::*algo, const SolveOptions &opts) {
+    return solve_jobs("Line", [&](BoundedQueue<BatchJob> &jobs) {
+        int status = 0;
+        long n = 0;
+        string line;
+        while (getline(in, line)) {
+            ++n;
+            if (line.find_first_not_of(" \t\r") == string::npos) continue;
+            istringstream tiles(line);
+            BatchJob job{ n, Board() };
+            if (!job.start.read(tiles)) {
+                cerr << "line " << n << ": expected " << Board::CELLS << " distinct tiles 0-" << Board::CELLS - 1 << endl;
+                status = 1;
+            } else if (!job.start.solvable()) {
+                cerr << "line " << n << ": board is not solvable" << endl;
+                status = 1;
+            } else {
+                jobs.push(job);
+            }
+        }
+        return status;
+    }, h, algo, opts);
+}
+
+// Solve shard k of n of a corpus. Results carry the boards' corpus indexes,
+// so the outputs of all shards merge into one table.
+int solve_corpus(const InstanceCorpus &corpus, int k, int n, Heuristic &h, Solver Solvers::*algo,
+                 const SolveOptions &opts) {
+    return solve_jobs("Instance", [&](BoundedQueue<BatchJob> &jobs) {
+        int status = 0;
+        for (uint64_t i = corpus.shard_begin(k, n); i < corpus.shard_begin(k + 1, n); ++i) {
+            BatchJob job{ (long)i, Board() };
+            if (!corpus.get(i, job.start)) {
+                cerr << "instance " << i << ": not a solvable board" << endl;
+                status = 1;
+            } else {
+                jobs.push(job);
+            }
+        }
+        return status;
+    }, h, algo, opts);
+}
+
+/*****************************************
+ * Benchmarks
+ *
+ * pa2 --bench solves fixed instance sets
+ * with every algorithm and heuristic, then
+ * times the hot-path primitives on their
+ * own. The built-in sets are seeded, so
+ * numbers compare across builds. Korf's 100
+ * instances (korf100.txt) are included on
+ * the 15-puzzle. They are solved by IDA*
+ * alone, and not with Manhattan or
+ * inversion distance, which take hours on
+ * them; the rest take a few minutes.
+ *****************************************/
+struct InstanceSet {
+    string name;
+    vector<Board> boards;
+    bool hard = false;      // Korf's: IDA* with the stronger heuristics only
+};
+
+// Boards in the --batch format, one per line, or an instance corpus
+bool read_instances(const string &path, InstanceSet &set) {
+    set.name = path;
+    if (InstanceCorpus::is_corpus(path)) {
+        InstanceCorpus corpus;
+        if (!corpus.load(path)) return false;
+        set.boards.resize(corpus.size());
+        for (uint64_t i = 0; i < corpus.size(); ++i) {
+            if (!corpus.get(i, set.boards[i])) {
+                cerr << path << ": instance " << i << " is not a solvable board" << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+    ifstream in(path);
+    if (!in) {
+        cerr << "Cannot open " << path << endl;
+        return false;
+    }
+    string line;
+    for (long n = 1; getline(in, line); ++n) {
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        istringstream tiles(line);
+        Board b;
+        if (!b.read(tiles) || !b.solvable()) {
+            cerr << path << ":" << n << ": not a solvable board" << endl;
+            return false;
+        }
+        set.boards.push_back(b);
+    }
+    return true;
+}
+
+// Korf's 100 instances are published as an instance number and 16 tiles,
+// for a goal with the blank in the top left and tile t in cell t. Turning
+// the board by 180 degrees and renaming tile t to 16 - t maps that goal
+// onto ours and keeps every distance.
+bool read_korf(const string &path, InstanceSet &set) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "Cannot open " << path << endl;
+        return false;
+    }
+    if (Board::ROWS != 4 || Board::COLS != 4) {
+        cerr << "Korf's instances are for the 15-puzzle" << endl;
+        return false;
+    }
+    set.name = "korf100";
+    set.hard = true;
+    string line;
+    for (long n = 1; getline(in, line); ++n) {
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        istringstream fields(line);
+        int number;
+        Board korf, b;
+        if (!(fields >> number) || !korf.read(fields)) {
+            cerr << path << ":" << n << ": expected an instance number and 16 tiles" << endl;
+            return false;
+        }
+        for (int c = 0; c < Board::CELLS; ++c) {
+            int t = korf.get(c);
+            b.set(Board::CELLS - 1 - c, t ? Board::CELLS - t : 0);
+        }
+        if (!b.solvable()) {
+            cerr << path << ":" << n << ": board is not solvable" << endl;
+            return false;
+        }
+        set.boards.push_back(b);
+    }
+    return true;
+}
+
+InstanceSet scrambled_set(int moves, int count, uint32_t seed) {
+    ManhattanDistance md;
+    seed_seq set_seed{ seed, (uint32_t)moves };
+    Problem p(md, set_seed);
+    InstanceSet set{ "scramble-" + to_string(moves), {} };
+    for (int i = 0; i < count; ++i)
+        set.boards.push_back(p.scramble(moves));
+    return set;
+}
+
+void bench_searches(const InstanceSet &set, vector<Heuristic*> &heuristics) {
+    for (auto algo : { make_pair("RBFS", &Solvers::rbfs), make_pair("IDA*", &Solvers::ida_star),
+                       make_pair("MM", &Solvers::mm) }) {
+        if (set.hard && algo.second != &Solvers::ida_star) continue;
+        for (Heuristic *h : heuristics) {
+            if (set.hard && (typeid(*h) == typeid(ManhattanDistance) || typeid(*h) == typeid(InversionDistance)))
+                continue;
+            Solver solve = solvers_for(*h).*algo.second;
+            Problem p(*h);
+            long moves = 0, nodes = 0;
+            chrono::time_point<chrono::high_resolution_clock> t0, t1;
+            t0 = chrono::high_resolution_clock::now();
+            for (Board start : set.boards) {
+                int nodes_expanded = 0;
+                moves += solve(start, p, nodes_expanded).size() - 1;
+                nodes += nodes_expanded;
+            }
+            t1 = chrono::high_resolution_clock::now();
+            double seconds = chrono::duration<double>(t1 - t0).count();
+            cout << set.name << "," << set.boards.size() << "," << algo.first << "," << h->get_name() << ","
+                 << moves << "," << nodes << "," << seconds << "," << nodes / seconds / 1e6 << endl;
+        }
+    }
+}
+
+// Time op(i) over `iterations` calls and print the cost per call. The
+// results are summed into a volatile so the calls cannot be optimized out.
+volatile long bench_sink;
+
+template<class Op>
+void bench_op(const string &name, long iterations, Op op) {
+    long sum = 0;
+    chrono::time_point<chrono::high_resolution_clock> t0, t1;
+    t0 = chrono::high_resolution_clock::now();
+    for (long i = 0; i < iterations; ++i)
+        sum += op(i);
+    t1 = chrono::high_resolution_clock::now();
+    bench_sink = sum;
+    cout << name << "," << chrono::duration<double, nano>(t1 - t0).count() / iterations << endl;
+}
+
+void bench_primitives(vector<Heuristic*> &heuristics, uint32_t seed) {
+    const long ITERATIONS = 10000000;
+    const int BOARDS = 1024;    // power of two
+    InstanceSet set = scrambled_set(100, BOARDS, seed);
+    vector<Board> &boards = set.boards;
+    ManhattanDistance md;
+    Problem p(md);
+    vector<Board::Action> acts(BOARDS);
+    for (int i = 0; i < BOARDS; ++i) {
+        Board::Action a[4];
+        acts[i] = a[i % p.actions(boards[i], Board::NONE, a)];
+    }
+
+    cout << "Primitive,ns/call" << endl;
+    bench_op("Board move", ITERATIONS, [&](long i) {
+        int k = i & (BOARDS - 1);
+        return (long)Board(boards[k], acts[k]).tiles;
+    });
+    bench_op("std::hash<Board>", ITERATIONS, [&](long i) {
+        return (long)hash<Board>()(boards[i & (BOARDS - 1)]);
+    });
+    bench_op("zobrist_key", ITERATIONS, [&](long i) {
+        return (long)zobrist_key(boards[i & (BOARDS - 1)].tiles);
+    });
+    bench_op("murmur_hash", ITERATIONS, [&](long i) {
+        return (long)murmur_hash(boards[i & (BOARDS - 1)]);
+    });
+    if (BOARD_RANKS) {
+        bench_op("rank_board", ITERATIONS, [&](long i) {
+            return (long)rank_board(boards[i & (BOARDS - 1)]);
+        });
+        bench_op("unrank_board", ITERATIONS, [&](long i) {
+            return (long)unrank_board(i * 0x9E3779B9ULL % SOLVABLE_BOARDS).tiles;
+        });
+    }
+    bench_op("Problem::successors", ITERATIONS, [&](long i) {
+        return (long)p.successors(boards[i & (BOARDS - 1)]).size();
+    });
+    bench_op("Problem::actions", ITERATIONS, [&](long i) {
+        Board::Action a[4];
+        return (long)p.actions(boards[i & (BOARDS - 1)], Board::NONE, a);
+    });
+    bench_op("Manhattan Distance all successors", ITERATIONS, [&](long i) {
+        const Board &b = boards[i & (BOARDS - 1)];
+        Board::Action a[4];
+        int h[4];
+        int n = p.actions(b, Board::NONE, a);
+        ManhattanDistance::update_all(b, 0, a, n, h);
+        return (long)h[0] + h[n - 1];
+    });
+    for (Heuristic *h : heuristics) {
+        Problem hp(*h);
+        vector<Board> scored = boards;
+        for (Board &b : scored)
+            b.H = h->init(b);
+        bench_op(h->get_name() + " full", ITERATIONS, [&](long i) {
+            return (long)(*h)(scored[i & (BOARDS - 1)]);
+        });
+        bench_op(h->get_name() + " incremental", ITERATIONS, [&](long i) {
+            int k = i & (BOARDS - 1);
+            Board b = scored[k];
+            hp.apply(b, acts[k]);
+            return (long)b.H;
+        });
+    }
+}
+
+int run_benchmarks(vector<InstanceSet> &sets, vector<Heuristic*> &heuristics, uint32_t seed) {
+    sets.insert(sets.begin(), { scrambled_set(30, 100, seed), scrambled_set(50, 100, seed) });
+    cout << "Set,Instances,Algorithm,Heuristic,Moves,Nodes_Expanded,Seconds,Mnodes/s" << endl;
+    for (InstanceSet &set : sets)
+        bench_searches(set, heuristics);
+    cout << endl;
+    bench_primitives(heuristics, seed);
+    return 0;
+}
+
+/*****************************************
+ * Self-test
+ *
+ * pa2 --self-test checks the permutation
+ * ranks behind the pattern databases and
+ * the dense board indexes. Index spaces up
+ * to EXHAUSTIVE are checked in full, larger
+ * ones at their ends and a seeded sample.
+ * Ranks must round-trip and, for the .pdb
+ * format, follow the lexicographic order of
+ * the sequences, which fixes them uniquely.
+ *****************************************/
+const uint64_t EXHAUSTIVE = 1 << 23;
+
+// Run check(idx) over [0, count) as above and print a summary line
+template<class Check>
+bool check_indexes(const string &name, uint64_t count, uint32_t seed, Check check) {
+    const long SAMPLES = 1000000;
+    bool exhaustive = count <= EXHAUSTIVE;
+    long checked = 0, failed = 0;
+    auto run = [&](uint64_t idx) {
+        ++checked;
+        if (!check(idx) && failed++ == 0) cerr << name << ": index " << idx << " fails" << endl;
+    };
+    if (exhaustive) {
+        for (uint64_t i = 0; i < count; ++i) run(i);
+    } else {
+        for (uint64_t i : { (uint64_t)0, (uint64_t)1, count - 2, count - 1 }) run(i);
+        SplitMix64 rng{ seed };
+        for (long n = 0; n < SAMPLES; ++n) run(rng() % count);
+    }
+    cout << name << ": " << checked << (exhaustive ? " indexes" : " sampled indexes") << ", "
+         << (failed ? to_string(failed) + " failed" : "ok") << endl;
+    return failed == 0;
+}
+
+// Whether x holds k distinct values below n
+bool distinct_below(const int *x, int k, int n) {
+    uint64_t seen = 0;
+    for (int i = 0; i < k; ++i) {
+        if (x[i] < 0 || x[i] >= n || (seen >> x[i] & 1)) return false;
+        seen |= 1ULL << x[i];
+    }
+    return true;
+}
+
+int run_self_tests(uint32_t seed) {
+    bool ok = true;
+    const int n = Board::CELLS;
+    uint64_t count = 1;
+    // on the 24-puzzle, ranks of more than 15 values overflow 64 bits
+    for (int k = 1; k <= n && count <= UINT64_MAX / (n - k + 1); ++k) {
+        count *= n - k + 1;
+        ok &= check_indexes("perm_rank " + to_string(k) + " of " + to_string(n), count, seed + k,
+                            [&](uint64_t idx) {
+            int x[Board::CELLS], prev[Board::CELLS];
+            perm_unrank(idx, x, k);
+            if (!distinct_below(x, k, n) || perm_rank(x, k) != idx) return false;
+            if (idx == 0) {                 // the smallest sequence, 0, 1, ..., k - 1
+                for (int i = 0; i < k; ++i)
+                    if (x[i] != i) return false;
+                return true;
+            }
+            perm_unrank(idx - 1, prev, k);
+            return lexicographical_compare(prev, prev + k, x, x + k);
+        });
+    }
+    if (BOARD_RANKS) ok &= check_indexes("rank_board", SOLVABLE_BOARDS, seed, [](uint64_t idx) {
+        Board b = unrank_board(idx);
+        int x[Board::CELLS];
+        for (int c = 0; c < Board::CELLS; ++c)
+            x[c] = b.get(c);
+        if (!distinct_below(x, Board::CELLS, Board::CELLS) || !b.solvable() || rank_board(b) != idx) return false;
+        // and back from a neighbouring board, which was not built by unrank_board
+        Board::Action acts[4];
+        Board c(b, acts[idx % Problem::actions(b, Board::NONE, acts)]);
+        uint64_t r = rank_board(c);
+        return r < SOLVABLE_BOARDS && unrank_board(r) == c && unrank_board(r).blank == c.blank;
+    });
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    int TOTAL_TRIALS = 10000;
+    const string DEFAULT_PDB = "pa2-663.pdb";
+    const string DEFAULT_KORF = "korf100.txt";
+    string pdb_file;
+    string solve_tiles;
+    string batch_file;
+    string heuristic_name = "lc";
+    string algorithm_name = "ida";
+    bool bench = false;
+    bool self_test = false;
+    vector<InstanceSet> bench_sets;
+    bool korf_given = false;
+    int threads = 0;
+    uint32_t seed = 531;
+    size_t tt_mb = 0;
+    string binary_file;
+    string trace_file;
+    string instances_file;
+    uint64_t instance_count = 1000000;
+    int walk = 0;
+    int shard = 0, shards = 1;
+    SearchLimits limits;
+    int fsm_depth = 0;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--gen-pdb") {
+            string out = i + 1 < argc ? argv[i + 1] : DEFAULT_PDB;
+            return PatternDatabase::generate(out, PatternDatabase::default_groups()) ? 0 : 1;
+        } else if (arg == "--pdb" && i + 1 < argc) {
+            pdb_file = argv[++i];
+        } else if (arg == "--solve" && i + 1 < argc) {
+            solve_tiles = argv[++i];
+        } else if (arg == "--bench") {
+            bench = true;
+        } else if (arg == "--self-test") {
+            self_test = true;
+
+        } else if (arg == "--bench-set" && i + 1 < argc) {
+            bench_sets.emplace_back();
+            if (!read_instances(argv[++i], bench_sets.back())) return 1;
+        } else if (arg == "--korf" && i + 1 < argc) {
+            korf_given = true;
+            bench_sets.emplace_back();
+            if (!read_korf(argv[++i], bench_sets.back())) return 1;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch_file = argv[++i];
+        } else if (arg == "--shard" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d/%d", &shard, &shards) != 2 || shard < 0 || shard >= shards) {
+                cerr << "--shard expects K/N with 0 <= K < N" << endl;
+                return 1;
+            }
+        } else if (arg == "--fsm" && i + 1 < argc) {
+            fsm_depth = stoi(argv[++i]);
+            if (fsm_depth < 1 || fsm_depth > MovePruner::MAX_DEPTH) {
+                cerr << "--fsm expects a depth from 1 to " << MovePruner::MAX_DEPTH << endl;
+                return 1;
+            }
+        } else if (arg == "--max-nodes" && i + 1 < argc) {
+            limits.max_nodes = stol(argv[++i]);
+        } else if (arg == "--max-ms" && i + 1 < argc) {
+            limits.max_ms = stol(argv[++i]);
+        } else if (arg == "--gen-instances" && i + 1 < argc) {
+            instances_file = argv[++i];
+        } else if (arg == "--count" && i + 1 < argc) {
+            instance_count = stoull(argv[++i]);
+        } else if (arg == "--walk" && i + 1 < argc) {
+            walk = stoi(argv[++i]);
+            if (walk < 0) {
+                usage();
+                return 1;
+            }
+        } else if (arg == "--algorithm" && i + 1 < argc) {
+            algorithm_name = argv[++i];
+        } else if (arg == "--heuristic" && i + 1 < argc) {
+            heuristic_name = argv[++i];
+        } else if (arg == "--trials" && i + 1 < argc) {
+            TOTAL_TRIALS = stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = stoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = stoul(argv[++i]);
+        } else if (arg == "--tt" && i + 1 < argc) {
+            tt_mb = stoul(argv[++i]);
+        } else if (arg == "--binary" && i + 1 < argc) {
+            binary_file = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+#ifndef PA2_STATS
+            cerr << "--trace needs a build with -DPA2_STATS" << endl;
+            return 1;
+#endif
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (self_test) return run_self_tests(seed);
+
+    if (!instances_file.empty())
+        return InstanceCorpus::generate(instances_file, instance_count, walk, seed, threads) ? 0 : 1;
+
+    // Duplicate strings for IDA*; 12 moves take about a second to learn
+    unique_ptr<MovePruner> pruner;
+    if (fsm_depth) pruner.reset(new MovePruner(fsm_depth));
+
+    LinearConflictMD  lc;
+    ManhattanDistance md;
+    InversionDistance id;
+    PatternDatabase   pdb;
+
+    // Walking distance tables take most of a minute on the 24-puzzle, so
+    // --solve and --batch only build them when asked for wd
+    bool one_heuristic = (!solve_tiles.empty() || !batch_file.empty()) && algorithm_name != "portfolio";
+    unique_ptr<WalkingDistance> wd;
+    if (!one_heuristic || heuristic_name == "wd") wd.reset(new WalkingDistance);
+
+    if (!solve_tiles.empty() || !batch_file.empty()) {
+        Heuristic *h = heuristic_name == "md" ? (Heuristic *)&md
+                     : heuristic_name == "lc" ? (Heuristic *)&lc
+                     : heuristic_name == "id" ? (Heuristic *)&id
+                     : heuristic_name == "wd" ? (Heuristic *)wd.get()
+                     : heuristic_name == "pdb" ? (Heuristic *)&pdb : nullptr;
+        Solver Solvers::*algo = algorithm_name == "ida" ? &Solvers::ida_star
+                              : algorithm_name == "rbfs" ? &Solvers::rbfs
+                              : algorithm_name == "mm" ? &Solvers::mm
+                              : algorithm_name == "anytime" ? &Solvers::anytime : nullptr;
+        // The portfolio races every heuristic, with the pattern database when --pdb is given
+        bool portfolio = algorithm_name == "portfolio" && !solve_tiles.empty();
+        if (!h || (!algo && !portfolio)) {
+            usage();
+            return 1;
+        }
+        if (portfolio ? !pdb_file.empty() : h == &pdb)
+            if (!pdb.load(pdb_file.empty() ? DEFAULT_PDB : pdb_file)) return 1;
+        // Bounds stored under one pruner state do not hold under another
+        if (pruner && tt_mb) {
+            cerr << "--fsm cannot be combined with --tt" << endl;
+            return 1;
+        }
+        if (tt_mb && algo != &Solvers::ida_star) {
+            cerr << "--tt needs --algorithm ida" << endl;
+            return 1;
+        }
+        SolveOptions opts;
+        opts.threads = threads;
+        opts.tt_mb = tt_mb;
+        opts.limits = limits;
+        opts.pruner = pruner.get();
+        if (portfolio) {
+            vector<Heuristic*> raced = { &md, &lc, &id, wd.get() };
+            if (!pdb_file.empty()) raced.push_back(&pdb);
+            return solve_portfolio(solve_tiles, portfolio_members(raced), opts);
+        }
+        if (!solve_tiles.empty()) return solve_one(solve_tiles, *h, algo, opts);
+        if (batch_file == "-") return solve_batch(cin, *h, algo, opts);
+        if (InstanceCorpus::is_corpus(batch_file)) {
+            InstanceCorpus corpus;
+            if (!corpus.load(batch_file)) return 1;
+            return solve_corpus(corpus, shard, shards, *h, algo, opts);
+        }
+        ifstream in(batch_file);
+        if (!in) {
+            cerr << "Cannot open " << batch_file << endl;
+            return 1;
+        }
+        return solve_batch(in, *h, algo, opts);
+    }
+
+    vector<Heuristic*> heuristics = { &md, &lc, &id, wd.get() };
+    if (!pdb_file.empty()) {
+        if (!pdb.load(pdb_file)) return 1;
+        heuristics.push_back(&pdb);
+    }
+    if (bench) {
+        // The standard set, unless another copy was given
+        if (!korf_given && Board::ROWS == 4 && Board::COLS == 4) {
+            if (ifstream(DEFAULT_KORF)) {
+                bench_sets.emplace_back();
+                if (!read_korf(DEFAULT_KORF, bench_sets.back())) return 1;
+            } else {
+                cerr << "No " << DEFAULT_KORF << " here; benchmarking without Korf's instances" << endl;
+            }
+        }
+        return run_benchmarks(bench_sets, heuristics, seed);
+    }
+
+    // Board_IDs are assigned in the same order as the serial loops used to.
+    struct Algorithm {
+        const char *name;
+        Solver Solvers::*solve;
+        bool transpositions;
+        bool pruning;
+    };
+    vector<Algorithm> algorithms = { { "RBFS", &Solvers::rbfs, false, false },
+                                     { "IDA*", &Solvers::ida_star, false, false } };
+    if (tt_mb) algorithms.push_back({ "IDA*+TT", &Solvers::ida_star, true, false });
+    if (pruner) algorithms.push_back({ "IDA*+FSM", &Solvers::ida_star, false, true });
+    // The IDA* variants after the first two solve the same boards as IDA*, so
+    // the node counts compare directly.
+    vector<Trial> trials;
+    int per_algorithm = 5 * TOTAL_TRIALS * heuristics.size();
+    for (size_t a = 0; a < algorithms.size(); ++a)
+        for (int scramble_size = 10; scramble_size <= 50; scramble_size += 10)
+            for (int num_trials = 0; num_trials < TOTAL_TRIALS; num_trials++)
+                for (size_t h = 0; h < heuristics.size(); ++h) {
+                    Algorithm &algo = algorithms[a];
+                    int id = trials.size() + 1;
+                    int board_seed = a > 1 ? id - (a - 1) * per_algorithm : id;
+                    trials.push_back({ id, board_seed, scramble_size, algo.name, heuristics[h], (uint8_t)a, (uint8_t)h,
+                                       solvers_for(*heuristics[h]).*algo.solve, algo.transpositions, algo.pruning,
+                                       0, 0, 0 });
+                }
+
+    vector<string> algorithm_names, heuristic_names;
+    for (Algorithm &algo : algorithms) algorithm_names.push_back(algo.name);
+    for (Heuristic *h : heuristics) heuristic_names.push_back(h->get_name());
+    ResultSink results(trials.size(), "pa2-" + std::to_string(TOTAL_TRIALS) + ".csv", binary_file, trace_file,
+                       algorithm_names, heuristic_names);
+    if (!results.ok()) return 1;
+    results.start();
+
+    // Each trial seeds its own generator from (seed, Board_ID), so the boards
+    // do not depend on the number of threads or on which worker runs what.
+    WorkStealingPool pool(threads);
+    cout << "Running " << trials.size() << " trials on " << pool.size() << " threads, seed " << seed << endl;
+    vector<unique_ptr<TranspositionTable>> tables(pool.size());    // one per worker
+    if (tt_mb)
+        for (auto &tt : tables)
+            tt.reset(new TranspositionTable(tt_mb));
+    atomic<int> done{ 0 };
+    mutex io;
+    for (Trial &t : trials) {
+        pool.submit([&](int worker) {
+            seed_seq trial_seed{ seed, (uint32_t)t.board_seed };
+            Problem p(*t.heuristic, trial_seed);
+            if (t.transpositions) p.tt = tables[worker].get();
+            if (t.pruning) p.pruner = pruner.get();
+            STAT(SearchStats stats;
+                 PerfCounters counters(!trace_file.empty());
+                 if (!trace_file.empty()) p.stats = &stats;)
+            Board start = p.scramble(t.scramble_num);
+
+            int nodes_expanded = 0;
+            chrono::time_point<chrono::high_resolution_clock> t0, t1;
+            STAT(counters.start();)
+            t0 = chrono::high_resolution_clock::now();
+            vector<Board> solution = t.solve(start, p, nodes_expanded);
+            t1 = chrono::high_resolution_clock::now();
+            STAT(counters.stop(stats);)
+            chrono::microseconds duration = chrono::duration_cast<chrono::microseconds>(t1 - t0);
+            t.moves = solution.size() - 1;
+            t.nodes_exp = nodes_expanded;
+            t.microseconds = duration.count();
+            Result r{ t.board_id, t.scramble_num, t.algo_code, t.heuristic_code, t.moves, t.nodes_exp,
+                      max(1L, t.microseconds) };
+            STAT(r.stats = move(stats);)
+            results.put(move(r));
+
+            int n = ++done;
+            if (n % max<int>(1, trials.size() / 10) == 0) {
+                lock_guard<mutex> lock(io);
+                cout << "Solved " << n << " / " << trials.size() << endl;
+            }
+        });
+    }
+    pool.wait();
+    results.close();
+
+    long plain = 0, with_tt = 0, with_pruning = 0;
+    for (Trial &t : trials) {
+        if (t.transpositions) with_tt += t.nodes_exp;
+        else if (t.pruning) with_pruning += t.nodes_exp;
+        else if (t.algo == "IDA*") plain += t.nodes_exp;
+    }
+    if (tt_mb) {
+        TranspositionTable::Stats sum;
+        for (auto &tt : tables) {
+            sum.probes += tt->stats.probes;
+            sum.hits += tt->stats.hits;
+            sum.cutoffs += tt->stats.cutoffs;
+        }
+        cout << "Transposition table (" << tt_mb << " MB per thread): " << sum.probes << " probes, "
+             << 100.0 * sum.hits / max(1L, sum.probes) << "% hits, " << sum.cutoffs << " cutoffs" << endl
+             << "IDA* nodes expanded: " << plain << ", with table: " << with_tt << endl;
+    }
+    if (pruner) {
+        cout << "Duplicate move pruning (" << pruner->duplicates() << " strings of up to " << fsm_depth
+             << " moves, " << pruner->states() << " states)" << endl
+             << "IDA* nodes expanded: " << plain << ", with pruning: " << with_pruning << endl;
+    }
+}